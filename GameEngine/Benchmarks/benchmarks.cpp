@@ -0,0 +1,877 @@
+#include "benchmarks.h"
+#include "..\Terrain\heightfield.h"
+#include "..\Terrain\terrain.h"
+#include "..\Terrain\terrainRaycast.h"
+#include "..\Physics\aabbBatch.h"
+#include "..\Physics\dynamicAabbTree.h"
+#include "..\Physics\hazardIndex.h"
+#include "..\Physics\meshBvh.h"
+#include "..\Utils\threadPool.h"
+#include "..\Model Loading\meshLoaderObj.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ---------- HEIGHTFIELD ----------
+
+// Double precision evaluation at the same float arguments the kernel sees
+static double referenceHeight(float x, float z)
+{
+    const float amplitude[3] = { 0.5f, 0.3f, 0.2f };
+    const float frequency[3] = { 0.05f, 0.15f, 0.3f };
+
+    double height = 0.0;
+    for (int i = 0; i < 3; ++i)
+        height += amplitude[i] * std::sin(static_cast<double>(x * frequency[i])) * std::cos(static_cast<double>(z * frequency[i]));
+    return height;
+}
+
+// Double precision dh/dx and dh/dz at the same float arguments
+static void referenceSlopes(float x, float z, double& slopeX, double& slopeZ)
+{
+    const float amplitude[3] = { 0.5f, 0.3f, 0.2f };
+    const float frequency[3] = { 0.05f, 0.15f, 0.3f };
+
+    slopeX = 0.0;
+    slopeZ = 0.0;
+    for (int i = 0; i < 3; ++i) {
+        double ax = static_cast<double>(x * frequency[i]);
+        double az = static_cast<double>(z * frequency[i]);
+        slopeX += amplitude[i] * frequency[i] * std::cos(ax) * std::cos(az);
+        slopeZ -= amplitude[i] * frequency[i] * std::sin(ax) * std::sin(az);
+    }
+}
+
+static void benchmarkHeightfield()
+{
+    const int pointCount = 1 << 20;
+    const int repeats = 20;
+
+    std::vector<float> xs(pointCount), zs(pointCount), heights(pointCount), scalarHeights(pointCount);
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> coord(-1000.0f, 1000.0f);
+    for (int i = 0; i < pointCount; ++i) {
+        xs[i] = coord(rng);
+        zs[i] = coord(rng);
+    }
+
+    std::cout << "Heightfield kernel, " << pointCount << " points x " << repeats << " runs"
+        << " (best path: " << getSimdPathName(getSimdPath()) << ")" << std::endl;
+
+    // CRT sin/cos, as the terrain was evaluated before the kernel existed
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        for (int i = 0; i < pointCount; ++i) {
+            float x = xs[i], z = zs[i];
+            heights[i] = 0.5f * sin(x * 0.05f) * cos(z * 0.05f)
+                + 0.3f * sin(x * 0.15f) * cos(z * 0.15f)
+                + 0.2f * sin(x * 0.3f) * cos(z * 0.3f);
+        }
+    }
+    double crtSeconds = secondsSince(start);
+    std::cout << "  CRT sin/cos: " << (pointCount * (double)repeats / crtSeconds) / 1e6 << " Mpoints/s" << std::endl;
+
+    evaluateTerrainHeights(xs.data(), zs.data(), scalarHeights.data(), pointCount, SimdPath::Scalar);
+
+    SimdPath paths[] = { SimdPath::Scalar, SimdPath::SSE2, SimdPath::AVX2 };
+    for (SimdPath path : paths) {
+        if (static_cast<int>(path) > static_cast<int>(getSimdPath()))
+            break;
+
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r)
+            evaluateTerrainHeights(xs.data(), zs.data(), heights.data(), pointCount, path);
+        double seconds = secondsSince(start);
+
+        double maxError = 0.0;
+        int mismatches = 0;
+        for (int i = 0; i < pointCount; ++i) {
+            maxError = std::fmax(maxError, std::fabs(heights[i] - referenceHeight(xs[i], zs[i])));
+            if (heights[i] != scalarHeights[i])
+                mismatches++;
+        }
+
+        std::cout << "  " << getSimdPathName(path) << ": "
+            << (pointCount * (double)repeats / seconds) / 1e6 << " Mpoints/s"
+            << ", speedup vs CRT " << crtSeconds / seconds << "x"
+            << ", max abs error " << maxError
+            << ", mismatches vs scalar " << mismatches << std::endl;
+    }
+
+    // Heights with analytic slopes, as the terrain build uses them
+    std::vector<float> slopesX(pointCount), slopesZ(pointCount), scalarSlopesX(pointCount), scalarSlopesZ(pointCount);
+    evaluateTerrainHeightsAndSlopes(xs.data(), zs.data(), scalarHeights.data(), scalarSlopesX.data(), scalarSlopesZ.data(),
+        pointCount, SimdPath::Scalar);
+
+    for (SimdPath path : paths) {
+        if (static_cast<int>(path) > static_cast<int>(getSimdPath()))
+            break;
+
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r)
+            evaluateTerrainHeightsAndSlopes(xs.data(), zs.data(), heights.data(), slopesX.data(), slopesZ.data(), pointCount, path);
+        double seconds = secondsSince(start);
+
+        double maxError = 0.0;
+        int mismatches = 0;
+        for (int i = 0; i < pointCount; ++i) {
+            double slopeX, slopeZ;
+            referenceSlopes(xs[i], zs[i], slopeX, slopeZ);
+            maxError = std::fmax(maxError, std::fabs(slopesX[i] - slopeX));
+            maxError = std::fmax(maxError, std::fabs(slopesZ[i] - slopeZ));
+            if (heights[i] != scalarHeights[i] || slopesX[i] != scalarSlopesX[i] || slopesZ[i] != scalarSlopesZ[i])
+                mismatches++;
+        }
+
+        std::cout << "  " << getSimdPathName(path) << " with slopes: "
+            << (pointCount * (double)repeats / seconds) / 1e6 << " Mpoints/s"
+            << ", max abs slope error " << maxError
+            << ", mismatches vs scalar " << mismatches << std::endl;
+    }
+}
+
+// ---------- PIT CARVING ----------
+
+static void benchmarkPits()
+{
+    const float size = 1000.0f;
+    const int divisions = 512;
+    const int pitCounts[] = { 10, 100, 1000, 10000 };
+
+    std::cout << "Terrain build with pits, " << divisions << " divisions" << std::endl;
+
+    for (int pitCount : pitCounts) {
+        std::vector<HazardZone> pits(pitCount);
+        std::mt19937 rng(pitCount);
+        std::uniform_real_distribution<float> coord(-size, size);
+        std::uniform_real_distribution<float> diameter(10.0f, 40.0f);
+        for (HazardZone& pit : pits) {
+            float d = diameter(rng);
+            pit.position = glm::vec3(coord(rng), 0.0f, coord(rng));
+            pit.size = glm::vec3(d, 10.0f, d);
+            pit.damage = 1;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        TerrainGrid grid = buildTerrainGrid(size, divisions, pits);
+        double buildSeconds = secondsSince(start);
+
+        // Every vertex against every pit, serially, as the terrain used to be carved
+        const int rowLength = grid.getRowLength();
+        std::vector<float> xs(rowLength), zs(rowLength), heights(rowLength);
+        for (int x = 0; x < rowLength; ++x)
+            xs[x] = grid.getCoordinate(x);
+
+        int mismatches = 0;
+        start = std::chrono::steady_clock::now();
+        for (int z = 0; z < rowLength; ++z) {
+            float fz = grid.getCoordinate(z);
+            std::fill(zs.begin(), zs.end(), fz);
+            evaluateTerrainHeights(xs.data(), zs.data(), heights.data(), rowLength);
+            for (int x = 0; x < rowLength; ++x) {
+                if (carvePits(xs[x], fz, heights[x], pits) != grid.heights[z * rowLength + x])
+                    mismatches++;
+            }
+        }
+        double bruteSeconds = secondsSince(start);
+
+        std::cout << "  " << pitCount << " pits: build " << buildSeconds * 1000.0 << " ms"
+            << ", per-vertex loop over all pits " << bruteSeconds * 1000.0 << " ms"
+            << ", height mismatches " << mismatches << std::endl;
+    }
+}
+
+// ---------- HAZARD LOOKUPS ----------
+
+static void benchmarkHazards()
+{
+    const int zoneCounts[] = { 10, 1000, 100000 };
+    const int pointCount = 1 << 20;
+
+    // Agents spread over the 2000x2000 map
+    std::vector<glm::vec3> points(pointCount);
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> coord(-1000.0f, 1000.0f);
+    for (glm::vec3& p : points)
+        p = glm::vec3(coord(rng), 0.0f, coord(rng));
+
+    std::cout << "Hazard zone containing each of " << pointCount << " points" << std::endl;
+
+    for (int zoneCount : zoneCounts) {
+        std::vector<HazardZone> zones(zoneCount);
+        std::uniform_real_distribution<float> diameter(10.0f, 40.0f);
+        for (HazardZone& zone : zones) {
+            float d = diameter(rng);
+            zone.position = glm::vec3(coord(rng), 0.0f, coord(rng));
+            zone.size = glm::vec3(d, 10.0f, d);
+            zone.damage = 1;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        HazardIndex index;
+        index.build(zones);
+        double buildSeconds = secondsSince(start);
+
+        std::vector<int> serial(pointCount), batched(pointCount);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < pointCount; ++i)
+            serial[i] = index.find(points[i]);
+        double serialSeconds = secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        index.find(points.data(), pointCount, batched.data());
+        double batchSeconds = secondsSince(start);
+
+        // Every zone in order, first match wins, as the per-caller loops did; a slice of
+        // the points when there are many zones
+        int scanCount = std::min(pointCount, std::max(1000, 200000000 / zoneCount));
+        int mismatches = 0, inside = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < scanCount; ++i) {
+            int found = -1;
+            for (int k = 0; k < zoneCount; ++k) {
+                if (hazardContainsPoint(zones[k], points[i].x, points[i].z)) {
+                    found = k;
+                    break;
+                }
+            }
+            if (found >= 0)
+                inside++;
+            if (found != serial[i])
+                mismatches++;
+        }
+        double scanSeconds = secondsSince(start);
+
+        for (int i = 0; i < pointCount; ++i) {
+            if (batched[i] != serial[i])
+                mismatches++;
+        }
+
+        std::cout << "  " << zoneCount << " zones: build " << buildSeconds * 1000.0 << " ms ("
+            << index.getCellCount() << " cells of " << index.getCellSize() << ")"
+            << ", index " << serialSeconds * 1e9 / pointCount << " ns/point"
+            << ", batched over " << ThreadPool::shared().getThreadCount() + 1 << " threads " << batchSeconds * 1e9 / pointCount << " ns/point"
+            << ", scan " << scanSeconds * 1e9 / scanCount << " ns/point"
+            << ", " << inside << "/" << scanCount << " checked points inside, mismatches " << mismatches << std::endl;
+    }
+}
+
+// ---------- TERRAIN RAY CASTS ----------
+
+// Fixed-step march over the analytic surface with a bisection refine, the way a ray had
+// to be answered without the pyramid. Returns the number of height evaluations.
+static int marchTerrainRay(const TerrainRay& ray, const std::vector<HazardZone>& pits, float step, float& distance)
+{
+    int evaluations = 0;
+    float previous = 0.0f;
+    for (float t = 0.0f; t <= ray.maxDistance; t += step) {
+        glm::vec3 p = ray.origin + ray.direction * t;
+        evaluations++;
+        if (p.y > carvePits(p.x, p.z, sampleTerrainBaseHeight(p.x, p.z), pits)) {
+            previous = t;
+            continue;
+        }
+
+        float low = previous, high = t;
+        for (int i = 0; i < 16; ++i) {
+            float mid = 0.5f * (low + high);
+            glm::vec3 q = ray.origin + ray.direction * mid;
+            evaluations++;
+            if (q.y > carvePits(q.x, q.z, sampleTerrainBaseHeight(q.x, q.z), pits))
+                low = mid;
+            else
+                high = mid;
+        }
+        distance = high;
+        return evaluations;
+    }
+    distance = -1.0f;
+    return evaluations;
+}
+
+static void benchmarkRaycast()
+{
+    const float size = 1000.0f;
+    const int divisions = 512;
+    const int pitCount = 100;
+    const int rayCount = 20000;
+    const float marchStep = 1.0f;
+
+    std::vector<HazardZone> pits(pitCount);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coord(-size * 0.9f, size * 0.9f);
+    std::uniform_real_distribution<float> diameter(10.0f, 40.0f);
+    for (HazardZone& pit : pits) {
+        float d = diameter(rng);
+        pit.position = glm::vec3(coord(rng), 0.0f, coord(rng));
+        pit.size = glm::vec3(d, 10.0f, d);
+        pit.damage = 1;
+    }
+
+    TerrainGrid grid = buildTerrainGrid(size, divisions, pits);
+
+    auto start = std::chrono::steady_clock::now();
+    TerrainHeightPyramid pyramid(grid);
+    double pyramidSeconds = secondsSince(start);
+
+    // Eye-height to hilltop origins looking slightly down, like line-of-sight and camera probes
+    std::uniform_real_distribution<float> raise(0.5f, 20.0f);
+    std::uniform_real_distribution<float> yaw(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> pitch(-0.35f, 0.02f);
+    std::vector<TerrainRay> rays(rayCount);
+    for (TerrainRay& ray : rays) {
+        float x = coord(rng), z = coord(rng);
+        float a = yaw(rng), b = pitch(rng);
+        ray.origin = glm::vec3(x, carvePits(x, z, sampleTerrainBaseHeight(x, z), pits) + raise(rng), z);
+        ray.direction = glm::vec3(std::cos(a) * std::cos(b), std::sin(b), std::sin(a) * std::cos(b));
+        ray.maxDistance = 500.0f;
+    }
+
+    std::vector<TerrainHit> serialHits(rayCount), batchHits(rayCount);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rayCount; ++i)
+        serialHits[i] = pyramid.raycast(rays[i]);
+    double serialSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    pyramid.raycast(rays.data(), batchHits.data(), rayCount);
+    double batchSeconds = secondsSince(start);
+
+    std::vector<float> marchDistances(rayCount);
+    long long evaluations = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rayCount; ++i)
+        evaluations += marchTerrainRay(rays[i], pits, marchStep, marchDistances[i]);
+    double marchSeconds = secondsSince(start);
+
+    int hits = 0, batchMismatches = 0, hitDisagreements = 0;
+    double distanceError = 0.0;
+    int compared = 0;
+    for (int i = 0; i < rayCount; ++i) {
+        if (serialHits[i].hit != batchHits[i].hit || serialHits[i].distance != batchHits[i].distance)
+            batchMismatches++;
+        if (serialHits[i].hit)
+            hits++;
+        if (serialHits[i].hit != (marchDistances[i] >= 0.0f)) {
+            hitDisagreements++;
+        } else if (serialHits[i].hit) {
+            distanceError += std::fabs(serialHits[i].distance - marchDistances[i]);
+            compared++;
+        }
+    }
+
+    std::cout << "Terrain ray casts, " << divisions << " divisions, " << pitCount << " pits, "
+        << rayCount << " rays (" << hits << " hit the ground)" << std::endl;
+    std::cout << "  pyramid build (" << pyramid.getLevelCount() << " levels) " << pyramidSeconds * 1000.0 << " ms" << std::endl;
+    std::cout << "  pyramid, serial " << serialSeconds * 1000.0 << " ms"
+        << " (" << serialSeconds * 1e9 / rayCount << " ns/ray)" << std::endl;
+    std::cout << "  pyramid, batched over " << ThreadPool::shared().getThreadCount() + 1 << " threads "
+        << batchSeconds * 1000.0 << " ms, mismatches vs serial " << batchMismatches << std::endl;
+    std::cout << "  march, step " << marchStep << " " << marchSeconds * 1000.0 << " ms"
+        << " (" << static_cast<double>(evaluations) / rayCount << " height evaluations/ray)" << std::endl;
+    std::cout << "  hit/miss disagreements vs march " << hitDisagreements
+        << ", mean distance difference " << (compared > 0 ? distanceError / compared : 0.0) << std::endl;
+}
+
+// ---------- COLLISION BROADPHASE ----------
+
+// Crate-sized boxes scattered over the 2000x2000 map, as ObjectInstance bounds
+static std::vector<Aabb> makePropBoxes(int count, unsigned int seed)
+{
+    std::vector<Aabb> boxes(count);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> coord(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> halfSize(2.0f, 11.0f);
+    for (Aabb& box : boxes) {
+        float h = halfSize(rng);
+        box = Aabb::fromCenter(glm::vec3(coord(rng), 0.0f, coord(rng)), glm::vec3(h));
+    }
+    return boxes;
+}
+
+// Player-sized boxes at random spots, standing on the ground
+static std::vector<Aabb> makePlayerBoxes(int count, unsigned int seed)
+{
+    std::vector<Aabb> boxes(count);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> coord(-1000.0f, 1000.0f);
+    for (Aabb& box : boxes)
+        box = Aabb::fromCenter(glm::vec3(coord(rng), 3.0f, coord(rng)), glm::vec3(2.0f, 3.0f, 2.0f));
+    return boxes;
+}
+
+static void benchmarkAabbTree()
+{
+    const int objectCounts[] = { 1000, 10000, 50000, 100000 };
+    const int queryCount = 10000;
+    const int frames = 100;
+
+    std::vector<Aabb> queries = makePlayerBoxes(queryCount, 1);
+    std::cout << "Dynamic AABB tree, " << queryCount << " player box and ray queries, "
+        << frames << " frames moving 1% of the objects" << std::endl;
+
+    for (int objectCount : objectCounts) {
+        std::vector<Aabb> boxes = makePropBoxes(objectCount, objectCount);
+
+        auto start = std::chrono::steady_clock::now();
+        DynamicAabbTree tree;
+        std::vector<int> proxies(objectCount);
+        for (int i = 0; i < objectCount; ++i)
+            proxies[i] = tree.createProxy(boxes[i], i);
+        double insertSeconds = secondsSince(start);
+
+        // Pushed crates: small steps, most of them absorbed by the fat boxes
+        std::mt19937 rng(objectCount);
+        std::uniform_int_distribution<int> pick(0, objectCount - 1);
+        std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+        int moves = 0, reinserts = 0;
+        start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; ++frame) {
+            for (int i = 0; i < objectCount / 100; ++i) {
+                int id = pick(rng);
+                glm::vec3 displacement(step(rng), 0.0f, step(rng));
+                boxes[id].min += displacement;
+                boxes[id].max += displacement;
+                if (tree.moveProxy(proxies[id], boxes[id], displacement))
+                    reinserts++;
+                moves++;
+            }
+        }
+        double moveSeconds = secondsSince(start);
+
+        std::vector<int> results;
+        long long treeHits = 0;
+        start = std::chrono::steady_clock::now();
+        for (const Aabb& query : queries) {
+            results.clear();
+            tree.query(query, results);
+            for (int id : results) {
+                if (boxes[id].overlaps(query))
+                    treeHits++;
+            }
+        }
+        double querySeconds = secondsSince(start);
+
+        long long scanHits = 0;
+        start = std::chrono::steady_clock::now();
+        for (const Aabb& query : queries) {
+            for (const Aabb& box : boxes) {
+                if (box.overlaps(query))
+                    scanHits++;
+            }
+        }
+        double scanSeconds = secondsSince(start);
+
+        long long rayCandidates = 0;
+        start = std::chrono::steady_clock::now();
+        for (const Aabb& query : queries) {
+            glm::vec3 origin = (query.min + query.max) * 0.5f;
+            glm::vec3 direction = glm::normalize(glm::vec3(origin.z, 0.0f, -origin.x) + glm::vec3(0.1f));
+            results.clear();
+            tree.raycast(origin, direction, 200.0f, results);
+            rayCandidates += results.size();
+        }
+        double raySeconds = secondsSince(start);
+
+        std::cout << "  " << objectCount << " objects: insert " << insertSeconds * 1000.0 << " ms"
+            << ", height " << tree.getHeight()
+            << ", move " << moveSeconds * 1e9 / moves << " ns (" << reinserts << "/" << moves << " reinserted)"
+            << ", box query " << querySeconds * 1e9 / queryCount << " ns vs scan " << scanSeconds * 1e9 / queryCount << " ns"
+            << ", overlaps " << treeHits << (treeHits == scanHits ? " (match)" : " (MISMATCH)")
+            << ", 200 unit ray " << raySeconds * 1e9 / queryCount << " ns (" << static_cast<double>(rayCandidates) / queryCount << " candidates)"
+            << std::endl;
+    }
+}
+
+// Per-object test as main.cpp did it before the SoA kernel: both boxes rebuilt from
+// position and half extents on every call, then the feet-above-top early out
+static bool referenceCollisionAllowJump(const glm::vec3& playerPos, const glm::vec3& playerHalf,
+    const glm::vec3& objectPos, const glm::vec3& objectHalf)
+{
+    float playerFeetY = playerPos.y - playerHalf.y;
+    float objectTopY = objectPos.y + objectHalf.y;
+    if (playerFeetY > objectTopY)
+        return false;
+
+    glm::vec3 pMin = playerPos - playerHalf, pMax = playerPos + playerHalf;
+    glm::vec3 oMin = objectPos - objectHalf, oMax = objectPos + objectHalf;
+    return pMin.x <= oMax.x && pMax.x >= oMin.x &&
+        pMin.y <= oMax.y && pMax.y >= oMin.y &&
+        pMin.z <= oMax.z && pMax.z >= oMin.z;
+}
+
+static void benchmarkAabbBatch()
+{
+    const int objectCounts[] = { 16, 256, 4096, 65536 };
+    const int queryCount = 2000;
+    const glm::vec3 playerHalf(2.0f, 3.0f, 2.0f);
+
+    // Players at random heights so some of them clear the crate tops
+    std::vector<glm::vec3> players(queryCount);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> coord(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> height(0.0f, 20.0f);
+    for (glm::vec3& p : players)
+        p = glm::vec3(coord(rng), height(rng), coord(rng));
+
+    std::cout << "Player box against every object, " << queryCount << " queries"
+        << " (best path: " << getSimdPathName(getSimdPath()) << ")" << std::endl;
+
+    for (int objectCount : objectCounts) {
+        // Dense enough that a few percent of the tests hit
+        std::vector<glm::vec3> centers(objectCount), halves(objectCount);
+        std::uniform_real_distribution<float> near(-40.0f, 40.0f);
+        std::uniform_real_distribution<float> halfSize(2.0f, 11.0f);
+        for (int i = 0; i < objectCount; ++i) {
+            const glm::vec3& anchor = players[i % queryCount];
+            centers[i] = glm::vec3(anchor.x + near(rng), 0.0f, anchor.z + near(rng));
+            halves[i] = glm::vec3(halfSize(rng));
+        }
+
+        AabbBatch batch;
+        for (int i = 0; i < objectCount; ++i)
+            batch.add(Aabb::fromCenter(centers[i], halves[i]));
+
+        const int words = AabbBatch::getMaskWordCount(objectCount);
+        std::vector<uint32_t> referenceMasks(static_cast<size_t>(words) * queryCount, 0);
+        long long hits = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int q = 0; q < queryCount; ++q) {
+            uint32_t* masks = &referenceMasks[static_cast<size_t>(q) * words];
+            for (int i = 0; i < objectCount; ++i) {
+                if (referenceCollisionAllowJump(players[q], playerHalf, centers[i], halves[i])) {
+                    masks[i / 32] |= 1u << (i % 32);
+                    hits++;
+                }
+            }
+        }
+        double referenceSeconds = secondsSince(start);
+
+        std::cout << "  " << objectCount << " objects (" << hits << " hits): per-object "
+            << referenceSeconds * 1e9 / (static_cast<double>(queryCount) * objectCount) << " ns/box";
+
+        SimdPath paths[] = { SimdPath::Scalar, SimdPath::SSE2, SimdPath::AVX2 };
+        std::vector<uint32_t> masks(static_cast<size_t>(words) * queryCount);
+        for (SimdPath path : paths) {
+            if (static_cast<int>(path) > static_cast<int>(getSimdPath()))
+                continue;
+
+            start = std::chrono::steady_clock::now();
+            for (int q = 0; q < queryCount; ++q)
+                batch.overlapMask(Aabb::fromCenter(players[q], playerHalf), &masks[static_cast<size_t>(q) * words], path);
+            double seconds = secondsSince(start);
+
+            std::cout << ", " << getSimdPathName(path) << " "
+                << seconds * 1e9 / (static_cast<double>(queryCount) * objectCount) << " ns/box"
+                << (masks == referenceMasks ? "" : " (MISMATCH)");
+        }
+        std::cout << std::endl;
+    }
+}
+
+// ---------- MESH BVH ----------
+
+// Bumpy sphere standing in for a detailed rock, rings x segments quads
+static void makeRockMesh(int rings, int segments, std::vector<Vertex>& vertices, std::vector<int>& indices)
+{
+    vertices.clear();
+    indices.clear();
+    for (int r = 0; r <= rings; ++r) {
+        float polar = 3.14159265f * r / rings;
+        for (int s = 0; s <= segments; ++s) {
+            float azimuth = 6.2831853f * s / segments;
+            float bump = 1.0f + 0.15f * std::sin(polar * 7.0f) * std::cos(azimuth * 5.0f) + 0.05f * std::sin(azimuth * 23.0f + polar * 11.0f);
+            vertices.push_back(Vertex(bump * std::sin(polar) * std::cos(azimuth), bump * std::cos(polar), bump * std::sin(polar) * std::sin(azimuth)));
+        }
+    }
+    for (int r = 0; r < rings; ++r) {
+        for (int s = 0; s < segments; ++s) {
+            int i0 = r * (segments + 1) + s, i1 = i0 + segments + 1;
+            int quad[6] = { i0, i1, i0 + 1, i0 + 1, i1, i1 + 1 };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+}
+
+static void benchmarkMeshBvhOn(const std::string& name, const std::vector<Vertex>& vertices, const std::vector<int>& indices)
+{
+    const int queryCount = 20000;
+    const MeshTransform transform = { glm::vec3(40.0f, 0.0f, -25.0f), glm::vec3(7.5f, 9.0f, 6.0f), 37.0f };
+
+    int builds = 0;
+    MeshBvh bvh;
+    auto start = std::chrono::steady_clock::now();
+    do {
+        bvh = MeshBvh(vertices, indices);
+        builds++;
+    } while (builds < 5 && secondsSince(start) < 0.5);
+    double buildSeconds = secondsSince(start) / builds;
+
+    // Reference triangles placed with the renderer's model matrix
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), transform.position);
+    model = glm::rotate(model, transform.rotationY, glm::vec3(0, 1, 0));
+    model = glm::scale(model, transform.scale);
+    int triangleCount = static_cast<int>(indices.size() / 3);
+    std::vector<glm::vec3> worldCorners(indices.size());
+    glm::vec3 worldMin(FLT_MAX), worldMax(-FLT_MAX);
+    for (size_t i = 0; i < indices.size(); ++i) {
+        worldCorners[i] = glm::vec3(model * glm::vec4(vertices[indices[i]].pos, 1.0f));
+        worldMin = glm::min(worldMin, worldCorners[i]);
+        worldMax = glm::max(worldMax, worldCorners[i]);
+    }
+    glm::vec3 center = (worldMin + worldMax) * 0.5f;
+    float size = glm::length(worldMax - worldMin) * 0.5f;
+
+    // Rays from a shell around the instance toward points inside its bounds; short
+    // capsules anywhere in the bounds grown by their radius
+    std::mt19937 rng(triangleCount);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> along(0.0f, 1.0f);
+    std::vector<glm::vec3> origins(queryCount), directions(queryCount), capsuleA(queryCount), capsuleB(queryCount);
+    const float capsuleRadius = size * 0.05f;
+    for (int i = 0; i < queryCount; ++i) {
+        glm::vec3 onShell = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(1e-4f));
+        glm::vec3 target = worldMin + (worldMax - worldMin) * glm::vec3(along(rng), along(rng), along(rng));
+        origins[i] = center + onShell * size * 2.0f;
+        directions[i] = glm::normalize(target - origins[i]);
+
+        glm::vec3 a = worldMin - glm::vec3(capsuleRadius) + (worldMax - worldMin + glm::vec3(2.0f * capsuleRadius)) * glm::vec3(along(rng), along(rng), along(rng));
+        capsuleA[i] = a;
+        capsuleB[i] = a + glm::vec3(unit(rng), unit(rng), unit(rng)) * size * 0.15f;
+    }
+
+    std::vector<MeshRayHit> rayHits(queryCount);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queryCount; ++i)
+        rayHits[i] = bvh.raycast(transform, origins[i], directions[i], size * 4.0f);
+    double raySeconds = secondsSince(start);
+
+    std::vector<MeshContact> contacts(queryCount);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queryCount; ++i)
+        contacts[i] = bvh.capsuleContact(transform, capsuleA[i], capsuleB[i], capsuleRadius);
+    double capsuleSeconds = secondsSince(start);
+
+    // Every triangle against a slice of the queries, sized to keep the loops to seconds
+    int referenceCount = std::min(queryCount, std::max(100, 40000000 / std::max(1, triangleCount)));
+    int rayMismatches = 0, capsuleMismatches = 0, rayHitCount = 0, capsuleHitCount = 0;
+    const float tolerance = size * 1e-4f;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < referenceCount; ++i) {
+        float best = size * 4.0f;
+        bool hit = false;
+        for (int k = 0; k < triangleCount; ++k) {
+            float t;
+            if (intersectRayTriangle(origins[i], directions[i], worldCorners[k * 3], worldCorners[k * 3 + 1], worldCorners[k * 3 + 2], t) && t <= best) {
+                best = t;
+                hit = true;
+            }
+        }
+        if (hit)
+            rayHitCount++;
+        if (hit != rayHits[i].hit || (hit && std::fabs(best - rayHits[i].distance) > tolerance))
+            rayMismatches++;
+    }
+    double rayReferenceSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < referenceCount; ++i) {
+        float best = capsuleRadius;
+        bool hit = false;
+        for (int k = 0; k < triangleCount; ++k) {
+            glm::vec3 onSegment, onTriangle;
+            float distance = segmentTriangleDistance(capsuleA[i], capsuleB[i], worldCorners[k * 3], worldCorners[k * 3 + 1], worldCorners[k * 3 + 2], onSegment, onTriangle);
+            if (distance <= best) {
+                best = distance;
+                hit = true;
+            }
+        }
+        if (hit)
+            capsuleHitCount++;
+        if (hit != contacts[i].hit || (hit && std::fabs(best - contacts[i].distance) > tolerance))
+            capsuleMismatches++;
+    }
+    double capsuleReferenceSeconds = secondsSince(start);
+
+    std::cout << "  " << name << ": " << triangleCount << " triangles, build " << buildSeconds * 1000.0 << " ms ("
+        << bvh.getNodeCount() << " nodes, depth " << bvh.getDepth() << ")" << std::endl;
+    std::cout << "    ray " << raySeconds * 1e9 / queryCount << " ns vs every triangle "
+        << rayReferenceSeconds * 1e9 / referenceCount << " ns, " << rayHitCount << "/" << referenceCount
+        << " checked rays hit, mismatches " << rayMismatches << std::endl;
+    std::cout << "    capsule " << capsuleSeconds * 1e9 / queryCount << " ns vs every triangle "
+        << capsuleReferenceSeconds * 1e9 / referenceCount << " ns, " << capsuleHitCount << "/" << referenceCount
+        << " checked capsules touch, mismatches " << capsuleMismatches << std::endl;
+}
+
+static void benchmarkMeshBvh()
+{
+    const char* modelPaths[] = {
+        "Resources/Models/sphere.obj",
+        "Resources/Models/StaticObjects/crates/Crate_1x1.obj",
+        "Resources/Models/StaticObjects/crates/Crate_1x1_Tall.obj",
+        "Resources/Models/StaticObjects/crates/Crate_1x2.obj",
+        "Resources/Models/StaticObjects/crates/Crate_1x2_Tall.obj",
+        "Resources/Models/StaticObjects/crates/Crate_2x2_Tall.obj",
+    };
+
+    std::cout << "Mesh BVH ray and capsule queries against one instance (scale 7.5 x 9 x 6, turned 37 degrees)" << std::endl;
+
+    MeshLoaderObj loader;
+    for (const char* path : modelPaths) {
+        // The loader terminates on missing files, check first so the run continues
+        if (!std::ifstream(path).good()) {
+            std::cout << "  " << path << ": not found, skipped" << std::endl;
+            continue;
+        }
+        Mesh mesh = loader.loadObjGeometry(path);
+        benchmarkMeshBvhOn(path, mesh.vertices, mesh.indices);
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<int> indices;
+    makeRockMesh(200, 400, vertices, indices);
+    benchmarkMeshBvhOn("generated rock", vertices, indices);
+}
+
+// ---------- INSTANCED OBJECTS ----------
+
+// Per-frame CPU work of drawing props that share a few meshes: building every prop's
+// model matrix for its own uniform upload and draw call, against gathering the cached
+// matrices into one instance array per mesh for one instanced draw each. GPU time needs
+// a window: run the game with --props <count>.
+static void benchmarkInstancing()
+{
+    const int propCounts[] = { 1000, 10000, 100000 };
+    const int meshCount = 5;    // the crate models
+    const int frames = 50;
+
+    std::cout << "Scattered props over " << meshCount << " meshes, " << frames << " frames, every prop visible" << std::endl;
+
+    for (int propCount : propCounts) {
+        std::vector<glm::vec3> positions(propCount);
+        std::vector<float> scales(propCount), rotations(propCount);
+        std::vector<int> meshes(propCount);
+        std::vector<glm::mat4> models(propCount);
+
+        std::mt19937 rng(propCount);
+        std::uniform_real_distribution<float> coord(-950.0f, 950.0f);
+        std::uniform_real_distribution<float> scale(4.0f, 10.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+        std::uniform_int_distribution<int> mesh(0, meshCount - 1);
+        for (int i = 0; i < propCount; ++i) {
+            positions[i] = glm::vec3(coord(rng), 0.0f, coord(rng));
+            scales[i] = scale(rng);
+            rotations[i] = angle(rng);
+            meshes[i] = mesh(rng);
+
+            models[i] = glm::translate(glm::mat4(1.0f), positions[i]);
+            models[i] = glm::rotate(models[i], rotations[i], glm::vec3(0, 1, 0));
+            models[i] = glm::scale(models[i], glm::vec3(scales[i]));
+        }
+
+        // One draw per prop, its matrix built for the uniform upload
+        std::vector<glm::mat4> uploaded(propCount);
+        long long perObjectDraws = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; ++frame) {
+            for (int i = 0; i < propCount; ++i) {
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), positions[i]);
+                model = glm::rotate(model, rotations[i], glm::vec3(0, 1, 0));
+                uploaded[i] = glm::scale(model, glm::vec3(scales[i]));
+                perObjectDraws++;
+            }
+        }
+        double perObjectSeconds = secondsSince(start);
+
+        // Cached matrices gathered per mesh, one draw per non-empty group
+        std::vector<std::vector<glm::mat4>> groups(meshCount);
+        long long instancedDraws = 0;
+        start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; ++frame) {
+            for (auto& group : groups)
+                group.clear();
+            for (int i = 0; i < propCount; ++i)
+                groups[meshes[i]].push_back(models[i]);
+            for (const auto& group : groups) {
+                if (!group.empty())
+                    instancedDraws++;
+            }
+        }
+        double instancedSeconds = secondsSince(start);
+
+        // Both ways draw every prop with the same matrix; each lands in its mesh's group in order
+        int mismatches = 0;
+        std::vector<int> next(meshCount, 0);
+        for (int i = 0; i < propCount; ++i) {
+            const glm::mat4& instance = groups[meshes[i]][next[meshes[i]]++];
+            if (std::memcmp(&instance, &models[i], sizeof(glm::mat4)) != 0 ||
+                std::memcmp(&uploaded[i], &models[i], sizeof(glm::mat4)) != 0)
+                mismatches++;
+        }
+
+        std::cout << "  " << propCount << " props: per object " << perObjectSeconds * 1000.0 / frames << " ms/frame, "
+            << perObjectDraws / frames << " draws; instanced " << instancedSeconds * 1000.0 / frames << " ms/frame, "
+            << instancedDraws / frames << " draws, " << propCount * sizeof(glm::mat4) / 1024 << " KB of instance data"
+            << ", mismatches " << mismatches << std::endl;
+    }
+}
+
+bool runBenchmark(const std::string& name)
+{
+    if (name == "heightfield") {
+        benchmarkHeightfield();
+        return true;
+    }
+    if (name == "pits") {
+        benchmarkPits();
+        return true;
+    }
+
+    if (name == "hazards") {
+        benchmarkHazards();
+        return true;
+    }
+
+    if (name == "raycast") {
+        benchmarkRaycast();
+        return true;
+    }
+
+    if (name == "aabbtree") {
+        benchmarkAabbTree();
+        return true;
+    }
+
+    if (name == "aabbbatch") {
+        benchmarkAabbBatch();
+        return true;
+    }
+
+    if (name == "meshbvh") {
+        benchmarkMeshBvh();
+        return true;
+    }
+
+    if (name == "instancing") {
+        benchmarkInstancing();
+        return true;
+    }
+
+    std::cout << "Unknown benchmark '" << name << "'. Available: heightfield, pits, hazards, raycast, aabbtree, aabbbatch, meshbvh, instancing" << std::endl;
+    return false;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+
+// Offline microbenchmarks, started with "GameEngine.exe --bench <name>".
+// Results go to std::cout; returns false when the name is unknown.
+bool runBenchmark(const std::string& name);
@@ -106,6 +106,13 @@ glm::mat4 Camera::getViewMatrix()
         cameraUp);
 }
 
+glm::mat4 Camera::getViewMatrix(const glm::vec3& eyePosition)
+{
+    return glm::lookAt(eyePosition,
+        eyePosition + cameraViewDirection,
+        cameraUp);
+}
+
 glm::vec3 Camera::getCameraPosition()
 {
     return cameraPosition;
@@ -119,4 +126,9 @@ glm::vec3 Camera::getCameraViewDirection()
 glm::vec3 Camera::getCameraUp()
 {
     return cameraUp;
+}
+
+glm::vec3 Camera::getCameraRight()
+{
+    return cameraRight;
 }
\ No newline at end of file
@@ -31,9 +31,11 @@ public:
     void setCameraViewDirection(glm::vec3 direction);
 
     glm::mat4 getViewMatrix();
+    glm::mat4 getViewMatrix(const glm::vec3& eyePosition);     // same orientation, seen from eyePosition
     glm::vec3 getCameraPosition();
     glm::vec3 getCameraViewDirection();
     glm::vec3 getCameraUp();
+    glm::vec3 getCameraRight();
 
 private:
     glm::vec3 cameraPosition;
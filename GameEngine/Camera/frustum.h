@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glm.hpp>
+
+// View frustum as six inward-facing planes (xyz = normal, w = distance), used to skip
+// geometry that cannot be on screen.
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    Frustum() {}
+
+    explicit Frustum(const glm::mat4& viewProjection)
+    {
+        extract(viewProjection);
+    }
+
+    // Gribb/Hartmann plane extraction from a projection * view matrix
+    void extract(const glm::mat4& m)
+    {
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+        planes[0] = row3 + row0;    // left
+        planes[1] = row3 - row0;    // right
+        planes[2] = row3 + row1;    // bottom
+        planes[3] = row3 - row1;    // top
+        planes[4] = row3 + row2;    // near
+        planes[5] = row3 - row2;    // far
+    }
+
+    // Conservative test: false only when the box is fully outside one plane
+    bool intersectsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const
+    {
+        for (int i = 0; i < 6; ++i) {
+            const glm::vec4& p = planes[i];
+            glm::vec3 farthest(
+                p.x >= 0.0f ? boxMax.x : boxMin.x,
+                p.y >= 0.0f ? boxMax.y : boxMin.y,
+                p.z >= 0.0f ? boxMax.z : boxMin.z);
+
+            if (p.x * farthest.x + p.y * farthest.y + p.z * farthest.z + p.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
@@ -3,14 +3,7 @@
 #include <vector>
 #include <string>
 #include <iostream>
-
-// Structure representing a hazard zone
-struct HazardZone {
-    glm::vec3 position;
-    glm::vec3 size;
-    int damage;
-    std::string name;
-};
+#include "Physics/hazardIndex.h"
 
 // Game state management class
 class GameState {
@@ -28,8 +21,20 @@ private:
     bool gameOver;
     int currentTask;
 
-    // Hazard zones
+    // Hazard zones, and the grid every point query goes through. The grid is rebuilt
+    // on the first query after a change, so adding or removing many zones builds it once.
     std::vector<HazardZone> hazardZones;
+    mutable HazardIndex hazardIndex;
+    mutable bool hazardIndexStale;
+    int hazardRevision;     // bumped on every change to hazardZones
+
+    const HazardIndex& currentHazardIndex() const {
+        if (hazardIndexStale) {
+            hazardIndex.build(hazardZones);
+            hazardIndexStale = false;
+        }
+        return hazardIndex;
+    }
 
 public:
     GameState()
@@ -40,6 +45,8 @@ public:
         , lastRegenTime(0.0f)
         , gameOver(false)
         , currentTask(0)
+        , hazardIndexStale(false)
+        , hazardRevision(0)
     {
     }
 
@@ -82,27 +89,50 @@ public:
         zone.damage = dmg;
         zone.name = name;
         hazardZones.push_back(zone);
+        hazardIndexStale = true;
+        hazardRevision++;
+    }
+
+    // Removes the first zone with this name; returns false when there is none
+    bool removeHazardZone(const std::string& name) {
+        for (auto it = hazardZones.begin(); it != hazardZones.end(); ++it) {
+            if (it->name == name) {
+                hazardZones.erase(it);
+                hazardIndexStale = true;
+                hazardRevision++;
+                return true;
+            }
+        }
+        return false;
     }
 
     const std::vector<HazardZone>& getHazardZones() const {
         return hazardZones;
     }
 
+    const HazardIndex& getHazardIndex() const {
+        return currentHazardIndex();
+    }
+
+    // Changes whenever a zone is added or removed, so copies of the zones (GPU textures)
+    // can tell when they are stale
+    int getHazardRevision() const {
+        return hazardRevision;
+    }
+
+    // Index of the first hazard zone containing pos (in XZ), -1 when there is none
+    int findHazardZone(const glm::vec3& pos) const {
+        return currentHazardIndex().find(pos);
+    }
+
     // Check if player is in any hazard zone
     bool checkHazardCollision(glm::vec3 playerPos, std::string& hazardName) {
-        for (const auto& hazard : hazardZones) {
-            float halfSizeX = hazard.size.x / 2.0f;
-            float halfSizeZ = hazard.size.z / 2.0f;
-
-            if (playerPos.x >= hazard.position.x - halfSizeX &&
-                playerPos.x <= hazard.position.x + halfSizeX &&
-                playerPos.z >= hazard.position.z - halfSizeZ &&
-                playerPos.z <= hazard.position.z + halfSizeZ) {
-                hazardName = hazard.name;
-                return true;
-            }
-        }
-        return false;
+        int zone = currentHazardIndex().find(playerPos);
+        if (zone < 0)
+            return false;
+
+        hazardName = hazardZones[zone].name;
+        return true;
     }
 
     // Update health system (damage and regeneration)
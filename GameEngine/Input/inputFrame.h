@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <glfw3.h>
+
+// Keys the simulation reads, InputFrame::keys has bit i set while INPUT_KEYS[i] is held
+const int INPUT_KEYS[] = {
+    GLFW_KEY_W, GLFW_KEY_A, GLFW_KEY_S, GLFW_KEY_D,
+    GLFW_KEY_SPACE, GLFW_KEY_LEFT_CONTROL,
+    GLFW_KEY_LEFT, GLFW_KEY_RIGHT, GLFW_KEY_UP, GLFW_KEY_DOWN,
+    GLFW_KEY_M, GLFW_KEY_P, GLFW_KEY_O, GLFW_KEY_C, GLFW_KEY_X,
+};
+const int INPUT_KEY_COUNT = sizeof(INPUT_KEYS) / sizeof(INPUT_KEYS[0]);
+
+// Everything the simulation takes from the player during one rendered frame. The game
+// loop fills it from the window, headless runs from a script, so the simulation itself
+// never touches GLFW.
+struct InputFrame
+{
+    uint32_t keys;
+    float mouseDeltaX;      // cursor movement in pixels, right is positive
+    float mouseDeltaY;      // up is positive
+    float scroll;           // wheel offset
+    float frameTime;        // seconds since the previous frame
+
+    InputFrame() : keys(0), mouseDeltaX(0.0f), mouseDeltaY(0.0f), scroll(0.0f), frameTime(0.0f) {}
+
+    bool isPressed(int key) const
+    {
+        for (int i = 0; i < INPUT_KEY_COUNT; ++i)
+            if (INPUT_KEYS[i] == key)
+                return (keys >> i) & 1u;
+        return false;
+    }
+
+    void setPressed(int key, bool pressed)
+    {
+        for (int i = 0; i < INPUT_KEY_COUNT; ++i)
+            if (INPUT_KEYS[i] == key)
+                keys = pressed ? keys | (1u << i) : keys & ~(1u << i);
+    }
+};
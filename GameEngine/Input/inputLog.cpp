@@ -0,0 +1,141 @@
+#include "inputLog.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+static const char INPUT_LOG_MAGIC[4] = { 'I', 'N', 'P', 'L' };
+
+static_assert(INPUT_KEY_COUNT <= 16, "input log stores the held keys in 16 bits");
+
+// Which optional parts follow a frame's flags byte and frame time
+static const uint8_t INPUT_LOG_KEYS = 1;
+static const uint8_t INPUT_LOG_MOUSE = 2;
+static const uint8_t INPUT_LOG_SCROLL = 4;
+
+struct InputLogHeader
+{
+    char magic[4];
+    uint32_t version;
+    float simTimestep;
+    uint32_t frameCount;
+};
+
+template <typename T>
+static void writeValue(std::vector<char>& out, const T& value)
+{
+    const char* p = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+// Reads the next value when the buffer still holds one
+template <typename T>
+static bool readValue(const std::vector<char>& in, size_t& offset, T& value)
+{
+    if (in.size() - offset < sizeof(T))
+        return false;
+    std::memcpy(&value, &in[offset], sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+InputLog::InputLog() : simTimestep(0.0f) {}
+
+InputLog::InputLog(float simTimestep) : simTimestep(simTimestep) {}
+
+bool InputLog::save(const std::string& path) const
+{
+    InputLogHeader header;
+    std::memcpy(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic));
+    header.version = INPUT_LOG_VERSION;
+    header.simTimestep = simTimestep;
+    header.frameCount = static_cast<uint32_t>(frames.size());
+
+    std::vector<char> out;
+    out.reserve(sizeof(header) + frames.size() * 5);
+    writeValue(out, header);
+
+    uint32_t previousKeys = 0;
+    for (const InputFrame& frame : frames) {
+        uint8_t flags = 0;
+        if (frame.keys != previousKeys)
+            flags |= INPUT_LOG_KEYS;
+        if (frame.mouseDeltaX != 0.0f || frame.mouseDeltaY != 0.0f)
+            flags |= INPUT_LOG_MOUSE;
+        if (frame.scroll != 0.0f)
+            flags |= INPUT_LOG_SCROLL;
+
+        writeValue(out, flags);
+        writeValue(out, frame.frameTime);
+        if (flags & INPUT_LOG_KEYS)
+            writeValue(out, static_cast<uint16_t>(frame.keys));
+        if (flags & INPUT_LOG_MOUSE) {
+            writeValue(out, frame.mouseDeltaX);
+            writeValue(out, frame.mouseDeltaY);
+        }
+        if (flags & INPUT_LOG_SCROLL)
+            writeValue(out, frame.scroll);
+
+        previousKeys = frame.keys;
+    }
+
+    std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (file)
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    if (!file) {
+        std::cout << "Could not write input log " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool InputLog::load(const std::string& path)
+{
+    frames.clear();
+
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file) {
+        std::cout << "Could not open input log " << path << std::endl;
+        return false;
+    }
+    std::vector<char> in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    size_t offset = 0;
+    InputLogHeader header;
+    if (!readValue(in, offset, header) ||
+        std::memcmp(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != INPUT_LOG_VERSION) {
+        std::cout << path << " is not an input log of version " << INPUT_LOG_VERSION << std::endl;
+        return false;
+    }
+    simTimestep = header.simTimestep;
+
+    frames.reserve(std::min<size_t>(header.frameCount, in.size() / 5));
+    uint32_t keys = 0;
+    for (uint32_t i = 0; i < header.frameCount; ++i) {
+        InputFrame frame;
+        uint8_t flags;
+        bool complete = readValue(in, offset, flags) && readValue(in, offset, frame.frameTime);
+
+        if (complete && (flags & INPUT_LOG_KEYS)) {
+            uint16_t stored;
+            complete = readValue(in, offset, stored);
+            keys = stored;
+        }
+        if (complete && (flags & INPUT_LOG_MOUSE))
+            complete = readValue(in, offset, frame.mouseDeltaX) && readValue(in, offset, frame.mouseDeltaY);
+        if (complete && (flags & INPUT_LOG_SCROLL))
+            complete = readValue(in, offset, frame.scroll);
+
+        if (!complete) {
+            std::cout << "Input log " << path << " ends after " << i << " of " << header.frameCount << " frames" << std::endl;
+            frames.clear();
+            return false;
+        }
+
+        frame.keys = keys;
+        frames.push_back(frame);
+    }
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "inputFrame.h"
+
+// Recorded play session: the InputFrame of every frame, in order. Replaying it through
+// advanceFrame from the same starting level repeats the session step for step, so runs
+// on different builds can be compared by frame time and end-state checksum.
+//
+// File: header (magic, version, simulation step, frame count), then per frame a flags
+// byte and the frame time, followed only by the parts that are present: the held keys
+// when they changed since the previous frame, the mouse delta when the mouse moved and
+// the scroll offset when the wheel turned. A typical frame takes 5 bytes.
+
+// Bump whenever the InputFrame layout, INPUT_KEYS or the encoding change
+const uint32_t INPUT_LOG_VERSION = 1;
+
+class InputLog
+{
+public:
+    InputLog();
+    explicit InputLog(float simTimestep);
+
+    void add(const InputFrame& frame) { frames.push_back(frame); }
+
+    // Returns false, with a message, when the file cannot be written / read or is not
+    // a complete log of this version
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    const InputFrame& getFrame(int index) const { return frames[index]; }
+    int getFrameCount() const { return static_cast<int>(frames.size()); }
+    float getSimTimestep() const { return simTimestep; }     // step the session was recorded with
+
+private:
+    float simTimestep;
+    std::vector<InputFrame> frames;
+};
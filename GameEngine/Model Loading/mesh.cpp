@@ -1,36 +1,54 @@
 #include "mesh.h"
 
-Mesh::Mesh() {}
+Mesh::Mesh() : boundsMin(0.0f), boundsMax(0.0f), samplerProgram(0), instanceVbo(0), instanceVao(0) {}
 
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<int> indices)
 {
 	this->vertices = vertices;
 	this->indices = indices;
+	this->samplerProgram = 0;
+	this->instanceVbo = 0;
+	this->instanceVao = 0;
 
+	computeBounds();
 	setup2();
 }
 
 Mesh::Mesh(std::vector<Vertex> vertices, std::vector<int> indices, std::vector<Texture> textures)
 {
-	this->vertices = vertices;
-	this->indices = indices;
+	this->vertices = std::move(vertices);
+	this->indices = std::move(indices);
 	this->textures = textures;
+	this->samplerProgram = 0;
+	this->instanceVbo = 0;
+	this->instanceVao = 0;
 
+	computeBounds();
 	setup();
 }
 
-// render the mesh
-void Mesh::draw(Shader shader)
+void Mesh::computeBounds()
+{
+	boundsMin = boundsMax = vertices.empty() ? glm::vec3(0.0f) : vertices[0].pos;
+	for (const Vertex& v : vertices)
+	{
+		boundsMin = glm::min(boundsMin, v.pos);
+		boundsMax = glm::max(boundsMax, v.pos);
+	}
+}
+
+// samplers are named after the texture type and its number among that type,
+// so the first diffuse texture goes to texture_diffuse1
+void Mesh::findSamplers(Shader& shader)
 {
 	unsigned int diffuseNr = 1;
 	unsigned int specularNr = 1;
 	unsigned int normalNr = 1;
 	unsigned int heightNr = 1;
 
+	samplerLocations.clear();
 	for (unsigned int i = 0; i < textures.size(); i++)
 	{
-		glActiveTexture(GL_TEXTURE0 + i); 
-											
 		std::string number;
 		std::string name = textures[i].type;
 		if (name == "texture_diffuse")
@@ -42,9 +60,28 @@ void Mesh::draw(Shader shader)
 		else if (name == "texture_height")
 			number = std::to_string(heightNr++); 
 
-		glUniform1i(glGetUniformLocation(shader.getId(), (name + number).c_str()), i);
+		samplerLocations.push_back(shader.getUniform(name + number));
+	}
+	samplerProgram = shader.getId();
+}
+
+void Mesh::bindTextures(Shader& shader)
+{
+	if (samplerProgram != shader.getId())
+		findSamplers(shader);
+
+	for (unsigned int i = 0; i < textures.size(); i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + i); 
+		glUniform1i(samplerLocations[i], i);
 		glBindTexture(GL_TEXTURE_2D, textures[i].id);
 	}
+}
+
+// render the mesh
+void Mesh::draw(Shader& shader)
+{
+	bindTextures(shader);
 
 	glBindVertexArray(vao);
 	glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
@@ -53,6 +90,47 @@ void Mesh::draw(Shader shader)
 	glActiveTexture(GL_TEXTURE0);
 }
 
+void Mesh::drawInstanced(Shader& shader, const glm::mat4* models, int count)
+{
+	if (count <= 0)
+		return;
+	if (instanceVao != vao)
+		setupInstancing();
+
+	bindTextures(shader);
+
+	// a fresh store every call, so the driver never waits on the previous frame's draw
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+	glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::mat4), models, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindVertexArray(vao);
+	glDrawElementsInstanced(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0, count);
+	glBindVertexArray(0);
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+// a mat4 attribute takes four vec4 locations, each advancing once per instance
+void Mesh::setupInstancing()
+{
+	if (instanceVbo == 0)
+		glGenBuffers(1, &instanceVbo);
+
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+	for (unsigned int column = 0; column < 4; column++)
+	{
+		glEnableVertexAttribArray(3 + column);
+		glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+		glVertexAttribDivisor(3 + column, 1);
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	instanceVao = vao;
+}
+
 void Mesh::setup()
 {
 	//create buffers
@@ -104,6 +182,7 @@ void Mesh::setup2()
 void Mesh::setTextures(std::vector<Texture> textures)
 {
 	this->textures = textures;
+	this->samplerProgram = 0;
 	setup();
 }
 
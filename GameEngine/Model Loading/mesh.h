@@ -73,15 +73,38 @@ public:
 
 	unsigned int vao, vbo, ibo;
 
+	// local-space extents of the vertex positions, set by the constructors
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+
 	Mesh();
 	Mesh(std::vector<Vertex> vertices, std::vector<int> indices);
 	Mesh(std::vector<Vertex> vertices, std::vector<int> indices, std::vector<Texture> textures);
 	~Mesh();
 
 	void setTextures(std::vector<Texture> textures);
+	void computeBounds();
 	void setup();
 	void setup2();
-	void draw(Shader shader);
+	void draw(Shader& shader);
+
+	// Draws count copies in one call, copy i placed by models[i] (the instanceModel
+	// attribute at locations 3-6). The matrices are uploaded to the mesh's instance
+	// buffer on every call.
+	void drawInstanced(Shader& shader, const glm::mat4* models, int count);
+
+private:
+	// sampler uniform of each texture in the program the mesh was last drawn with
+	std::vector<GLint> samplerLocations;
+	int samplerProgram;
+
+	// per-instance model matrices, attached to the vao they were set up on
+	unsigned int instanceVbo;
+	unsigned int instanceVao;
+
+	void findSamplers(Shader& shader);
+	void bindTextures(Shader& shader);
+	void setupInstancing();
 };
 
   
\ No newline at end of file
@@ -3,11 +3,8 @@
 
 MeshLoaderObj::MeshLoaderObj() {};
 
-Mesh MeshLoaderObj::loadObj(const std::string &filename)
+void MeshLoaderObj::parseObj(const std::string &filename, std::vector<Vertex> &vertices, std::vector<int> &indices)
 {
-	std::vector<Vertex> vertices;
-	std::vector<int> indices;
-
 	//Reading Obj file
 	std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
 	if (!file.good())
@@ -149,12 +146,28 @@ Mesh MeshLoaderObj::loadObj(const std::string &filename)
 	}
 
 	std::cout << "Loading:  " << filename << std::endl;
+}
+
+Mesh MeshLoaderObj::loadObj(const std::string &filename)
+{
+	std::vector<Vertex> vertices;
+	std::vector<int> indices;
+	parseObj(filename, vertices, indices);
 
 	Mesh mesh(vertices, indices);
 
 	return mesh;
 }
 
+Mesh MeshLoaderObj::loadObjGeometry(const std::string &filename)
+{
+	Mesh mesh;
+	parseObj(filename, mesh.vertices, mesh.indices);
+	mesh.computeBounds();
+
+	return mesh;
+}
+
 Mesh MeshLoaderObj::loadObj(const std::string &filename, std::vector<Texture> textures)
 {
 	Mesh mesh = loadObj(filename);
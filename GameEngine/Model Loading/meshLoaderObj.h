@@ -14,5 +14,11 @@ class MeshLoaderObj
 		MeshLoaderObj();
 		Mesh loadObj(const std::string &filename, std::vector<Texture> textures);
 		Mesh loadObj(const std::string &filename);
+
+		// Vertices, indices and bounds only, without GL buffers (headless runs, benchmarks)
+		Mesh loadObjGeometry(const std::string &filename);
+
+	private:
+		void parseObj(const std::string &filename, std::vector<Vertex> &vertices, std::vector<int> &indices);
 };
 
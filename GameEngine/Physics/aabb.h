@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glm.hpp>
+
+// Axis-aligned box given by its min and max corners, touching boxes overlap
+struct Aabb
+{
+    glm::vec3 min;
+    glm::vec3 max;
+
+    static Aabb fromCenter(const glm::vec3& center, const glm::vec3& halfExtents)
+    {
+        Aabb box = { center - halfExtents, center + halfExtents };
+        return box;
+    }
+
+    bool overlaps(const Aabb& other) const
+    {
+        return min.x <= other.max.x && max.x >= other.min.x &&
+            min.y <= other.max.y && max.y >= other.min.y &&
+            min.z <= other.max.z && max.z >= other.min.z;
+    }
+};
@@ -0,0 +1,277 @@
+#include "aabbBatch.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define AABB_BATCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define AABB_BATCH_TARGET_AVX2
+#else
+#define AABB_BATCH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// Boxes per padding block, the widest path's lane count
+static const int AABB_BATCH_LANES = 8;
+
+AabbBatch::AabbBatch()
+    : count(0)
+{
+}
+
+// Grows the arrays by whole blocks of empty boxes (min = +max, max = -max)
+void AabbBatch::reserveSlot(int index)
+{
+    if (index < static_cast<int>(minX.size()))
+        return;
+
+    size_t padded = (static_cast<size_t>(index) / AABB_BATCH_LANES + 1) * AABB_BATCH_LANES;
+    minX.resize(padded, FLT_MAX);
+    minY.resize(padded, FLT_MAX);
+    minZ.resize(padded, FLT_MAX);
+    maxX.resize(padded, -FLT_MAX);
+    maxY.resize(padded, -FLT_MAX);
+    maxZ.resize(padded, -FLT_MAX);
+}
+
+int AabbBatch::add(const Aabb& box)
+{
+    reserveSlot(count);
+    set(count, box);
+    return count++;
+}
+
+void AabbBatch::set(int index, const Aabb& box)
+{
+    minX[index] = box.min.x;
+    minY[index] = box.min.y;
+    minZ[index] = box.min.z;
+    maxX[index] = box.max.x;
+    maxY[index] = box.max.y;
+    maxZ[index] = box.max.z;
+}
+
+void AabbBatch::removeLast()
+{
+    count--;
+    Aabb empty = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+    set(count, empty);
+}
+
+void AabbBatch::clear()
+{
+    minX.clear(); minY.clear(); minZ.clear();
+    maxX.clear(); maxY.clear(); maxZ.clear();
+    count = 0;
+}
+
+Aabb AabbBatch::get(int index) const
+{
+    Aabb box = {
+        glm::vec3(minX[index], minY[index], minZ[index]),
+        glm::vec3(maxX[index], maxY[index], maxZ[index])
+    };
+    return box;
+}
+
+// ---------- SCALAR ----------
+
+static inline bool overlapsScalar(const Aabb& q, float x0, float y0, float z0, float x1, float y1, float z1)
+{
+    return x0 <= q.max.x && x1 >= q.min.x &&
+        y0 <= q.max.y && y1 >= q.min.y &&
+        z0 <= q.max.z && z1 >= q.min.z;
+}
+
+// ---------- SSE2 / AVX2 ----------
+
+#ifdef AABB_BATCH_X86
+
+// Lane mask of boxes overlapping q, for four boxes given component-wise
+static inline int overlapLanesSSE2(const __m128* q,
+    __m128 x0, __m128 y0, __m128 z0, __m128 x1, __m128 y1, __m128 z1)
+{
+    __m128 hit = _mm_and_ps(_mm_cmple_ps(x0, q[3]), _mm_cmpge_ps(x1, q[0]));
+    hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(y0, q[4]), _mm_cmpge_ps(y1, q[1])));
+    hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(z0, q[5]), _mm_cmpge_ps(z1, q[2])));
+    return _mm_movemask_ps(hit);
+}
+
+AABB_BATCH_TARGET_AVX2
+static inline int overlapLanesAVX2(const __m256* q,
+    __m256 x0, __m256 y0, __m256 z0, __m256 x1, __m256 y1, __m256 z1)
+{
+    __m256 hit = _mm256_and_ps(_mm256_cmp_ps(x0, q[3], _CMP_LE_OQ), _mm256_cmp_ps(x1, q[0], _CMP_GE_OQ));
+    hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(y0, q[4], _CMP_LE_OQ), _mm256_cmp_ps(y1, q[1], _CMP_GE_OQ)));
+    hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(z0, q[5], _CMP_LE_OQ), _mm256_cmp_ps(z1, q[2], _CMP_GE_OQ)));
+    return _mm256_movemask_ps(hit);
+}
+
+AABB_BATCH_TARGET_AVX2
+static void sweepAVX2(const Aabb& query, const float* const* arrays, int blocks, uint32_t* masks)
+{
+    const __m256 q[6] = {
+        _mm256_set1_ps(query.min.x), _mm256_set1_ps(query.min.y), _mm256_set1_ps(query.min.z),
+        _mm256_set1_ps(query.max.x), _mm256_set1_ps(query.max.y), _mm256_set1_ps(query.max.z)
+    };
+
+    for (int b = 0; b < blocks; ++b) {
+        int i = b * 8;
+        uint32_t lanes = static_cast<uint32_t>(overlapLanesAVX2(q,
+            _mm256_loadu_ps(arrays[0] + i), _mm256_loadu_ps(arrays[1] + i), _mm256_loadu_ps(arrays[2] + i),
+            _mm256_loadu_ps(arrays[3] + i), _mm256_loadu_ps(arrays[4] + i), _mm256_loadu_ps(arrays[5] + i)));
+        masks[i / 32] |= lanes << (i % 32);
+    }
+}
+
+static void sweepSSE2(const Aabb& query, const float* const* arrays, int blocks, uint32_t* masks)
+{
+    const __m128 q[6] = {
+        _mm_set1_ps(query.min.x), _mm_set1_ps(query.min.y), _mm_set1_ps(query.min.z),
+        _mm_set1_ps(query.max.x), _mm_set1_ps(query.max.y), _mm_set1_ps(query.max.z)
+    };
+
+    for (int b = 0; b < blocks * 2; ++b) {
+        int i = b * 4;
+        uint32_t lanes = static_cast<uint32_t>(overlapLanesSSE2(q,
+            _mm_loadu_ps(arrays[0] + i), _mm_loadu_ps(arrays[1] + i), _mm_loadu_ps(arrays[2] + i),
+            _mm_loadu_ps(arrays[3] + i), _mm_loadu_ps(arrays[4] + i), _mm_loadu_ps(arrays[5] + i)));
+        masks[i / 32] |= lanes << (i % 32);
+    }
+}
+
+AABB_BATCH_TARGET_AVX2
+static bool gatherAVX2(const Aabb& query, const float* const* arrays, const int* ids, int idCount, uint32_t* masks)
+{
+    const __m256 q[6] = {
+        _mm256_set1_ps(query.min.x), _mm256_set1_ps(query.min.y), _mm256_set1_ps(query.min.z),
+        _mm256_set1_ps(query.max.x), _mm256_set1_ps(query.max.y), _mm256_set1_ps(query.max.z)
+    };
+
+    uint32_t any = 0;
+    int k = 0;
+    for (; k + 8 <= idCount; k += 8) {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids + k));
+        uint32_t lanes = static_cast<uint32_t>(overlapLanesAVX2(q,
+            _mm256_i32gather_ps(arrays[0], index, 4), _mm256_i32gather_ps(arrays[1], index, 4),
+            _mm256_i32gather_ps(arrays[2], index, 4), _mm256_i32gather_ps(arrays[3], index, 4),
+            _mm256_i32gather_ps(arrays[4], index, 4), _mm256_i32gather_ps(arrays[5], index, 4)));
+        masks[k / 32] |= lanes << (k % 32);
+        any |= lanes;
+    }
+    for (; k < idCount; ++k) {
+        int id = ids[k];
+        if (overlapsScalar(query, arrays[0][id], arrays[1][id], arrays[2][id], arrays[3][id], arrays[4][id], arrays[5][id])) {
+            masks[k / 32] |= 1u << (k % 32);
+            any = 1;
+        }
+    }
+    return any != 0;
+}
+
+static bool gatherSSE2(const Aabb& query, const float* const* arrays, const int* ids, int idCount, uint32_t* masks)
+{
+    const __m128 q[6] = {
+        _mm_set1_ps(query.min.x), _mm_set1_ps(query.min.y), _mm_set1_ps(query.min.z),
+        _mm_set1_ps(query.max.x), _mm_set1_ps(query.max.y), _mm_set1_ps(query.max.z)
+    };
+
+    __m128 lanes[6];
+    uint32_t any = 0;
+    int k = 0;
+    for (; k + 4 <= idCount; k += 4) {
+        const int* id = ids + k;
+        for (int c = 0; c < 6; ++c)
+            lanes[c] = _mm_setr_ps(arrays[c][id[0]], arrays[c][id[1]], arrays[c][id[2]], arrays[c][id[3]]);
+
+        uint32_t hits = static_cast<uint32_t>(overlapLanesSSE2(q, lanes[0], lanes[1], lanes[2], lanes[3], lanes[4], lanes[5]));
+        masks[k / 32] |= hits << (k % 32);
+        any |= hits;
+    }
+    for (; k < idCount; ++k) {
+        int id = ids[k];
+        if (overlapsScalar(query, arrays[0][id], arrays[1][id], arrays[2][id], arrays[3][id], arrays[4][id], arrays[5][id])) {
+            masks[k / 32] |= 1u << (k % 32);
+            any = 1;
+        }
+    }
+    return any != 0;
+}
+
+#endif // AABB_BATCH_X86
+
+// ---------- DISPATCH ----------
+
+bool AabbBatch::overlapMask(const Aabb& query, uint32_t* masks) const
+{
+    return overlapMask(query, masks, getSimdPath());
+}
+
+bool AabbBatch::overlapMask(const Aabb& query, uint32_t* masks, SimdPath path) const
+{
+    std::memset(masks, 0, getMaskWordCount(count) * sizeof(uint32_t));
+    if (count == 0)
+        return false;
+
+#ifdef AABB_BATCH_X86
+    // Whole blocks are tested, padding included; a block never straddles a mask word.
+    // Padding bits are cleared afterwards in case the query itself spans +-FLT_MAX.
+    if (path != SimdPath::Scalar) {
+        const float* arrays[6] = { minX.data(), minY.data(), minZ.data(), maxX.data(), maxY.data(), maxZ.data() };
+        const int blocks = (count + AABB_BATCH_LANES - 1) / AABB_BATCH_LANES;
+
+        if (path == SimdPath::AVX2 && getSimdPath() == SimdPath::AVX2)
+            sweepAVX2(query, arrays, blocks, masks);
+        else
+            sweepSSE2(query, arrays, blocks, masks);
+
+        if (count % 32 != 0)
+            masks[count / 32] &= (1u << (count % 32)) - 1u;
+
+        for (int w = 0; w < getMaskWordCount(count); ++w) {
+            if (masks[w] != 0)
+                return true;
+        }
+        return false;
+    }
+#endif
+
+    bool any = false;
+    for (int i = 0; i < count; ++i) {
+        if (overlapsScalar(query, minX[i], minY[i], minZ[i], maxX[i], maxY[i], maxZ[i])) {
+            masks[i / 32] |= 1u << (i % 32);
+            any = true;
+        }
+    }
+    return any;
+}
+
+bool AabbBatch::overlapMask(const Aabb& query, const int* ids, int idCount, uint32_t* masks) const
+{
+    return overlapMask(query, ids, idCount, masks, getSimdPath());
+}
+
+bool AabbBatch::overlapMask(const Aabb& query, const int* ids, int idCount, uint32_t* masks, SimdPath path) const
+{
+    std::memset(masks, 0, getMaskWordCount(idCount) * sizeof(uint32_t));
+
+#ifdef AABB_BATCH_X86
+    const float* arrays[6] = { minX.data(), minY.data(), minZ.data(), maxX.data(), maxY.data(), maxZ.data() };
+    if (path == SimdPath::AVX2 && getSimdPath() == SimdPath::AVX2)
+        return gatherAVX2(query, arrays, ids, idCount, masks);
+    if (path != SimdPath::Scalar)
+        return gatherSSE2(query, arrays, ids, idCount, masks);
+#endif
+
+    bool any = false;
+    for (int k = 0; k < idCount; ++k) {
+        int id = ids[k];
+        if (overlapsScalar(query, minX[id], minY[id], minZ[id], maxX[id], maxY[id], maxZ[id])) {
+            masks[k / 32] |= 1u << (k % 32);
+            any = true;
+        }
+    }
+    return any;
+}
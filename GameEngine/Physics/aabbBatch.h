@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "aabb.h"
+#include "..\Utils\cpuFeatures.h"
+
+// Box bounds stored as structure-of-arrays (one float array per min/max component) so
+// one query box is tested against 8 (AVX2) or 4 (SSE2) boxes per comparison. Arrays are
+// padded to a multiple of 8 with empty boxes that never overlap anything.
+//
+// The player's "allow jump" rule (no collision once the feet are above a box's top face)
+// is the query.min.y <= box.max.y comparison of the overlap test, so it needs no extra lane.
+class AabbBatch
+{
+public:
+    AabbBatch();
+
+    // Returns the new box's index
+    int add(const Aabb& box);
+    void set(int index, const Aabb& box);
+    void removeLast();
+    void clear();
+
+    Aabb get(int index) const;
+    int size() const { return count; }
+
+    // Words needed for a mask covering count boxes, one bit per box
+    static int getMaskWordCount(int count) { return (count + 31) / 32; }
+
+    // Bit i of masks is set when box i overlaps query. masks must hold
+    // getMaskWordCount(size()) words. Returns true when any bit is set.
+    bool overlapMask(const Aabb& query, uint32_t* masks) const;
+    bool overlapMask(const Aabb& query, uint32_t* masks, SimdPath path) const;
+
+    // Bit k of masks is set when box ids[k] overlaps query (candidates from a broadphase).
+    // masks must hold getMaskWordCount(idCount) words.
+    bool overlapMask(const Aabb& query, const int* ids, int idCount, uint32_t* masks) const;
+    bool overlapMask(const Aabb& query, const int* ids, int idCount, uint32_t* masks, SimdPath path) const;
+
+private:
+    void reserveSlot(int index);
+
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+    int count;
+};
@@ -0,0 +1,63 @@
+#include "characterController.h"
+#include <algorithm>
+#include <cmath>
+
+// Contacts whose normal is flatter than this against the XZ plane are floors or ceilings
+static const float MIN_PUSH_SLOPE = 0.3f;
+static const int MAX_PUSHES_PER_STEP = 4;
+static const int MAX_STEPS = 64;
+
+// Pulls position back toward center in XZ so it is at most maxTravel away
+static void clampTravel(glm::vec3& position, const glm::vec3& center, float maxTravel)
+{
+    glm::vec2 offset(position.x - center.x, position.z - center.z);
+    float travel = glm::length(offset);
+    if (travel > maxTravel) {
+        offset *= maxTravel / travel;
+        position.x = center.x + offset.x;
+        position.z = center.z + offset.y;
+    }
+}
+
+glm::vec3 moveAndSlide(const glm::vec3& center, float halfAxis, float radius, const glm::vec3& displacement,
+    const CapsuleContactQuery& closestContact)
+{
+    float length = glm::length(displacement);
+    if (!(length > 0.0f))
+        return glm::vec3(0.0f);
+
+    int steps = std::min(MAX_STEPS, std::max(1, static_cast<int>(std::ceil(length / (radius * 0.5f)))));
+    glm::vec3 step = displacement / static_cast<float>(steps);
+    glm::vec3 axis(0.0f, halfAxis, 0.0f);
+    glm::vec3 position = center;
+    float maxTravel = length + MOVE_AND_SLIDE_SKIN;
+
+    for (int s = 0; s < steps; ++s) {
+        position += step;
+        clampTravel(position, center, maxTravel);
+
+        for (int push = 0; push < MAX_PUSHES_PER_STEP; ++push) {
+            MeshContact contact = closestContact(position - axis, position + axis, radius + MOVE_AND_SLIDE_SKIN);
+            if (!contact.hit)
+                break;
+
+            glm::vec3 normal(contact.normal.x, 0.0f, contact.normal.z);
+            float slope = glm::length(normal);
+            if (slope < MIN_PUSH_SLOPE)
+                break;
+            normal /= slope;
+
+            // Moving d along the horizontal normal moves d * slope away from the surface
+            float depth = radius + MOVE_AND_SLIDE_SKIN - contact.distance;
+            position += normal * (depth / slope);
+            clampTravel(position, center, maxTravel);
+
+            // Slide: keep only the part of the step that runs along the surface
+            float into = glm::dot(step, normal);
+            if (into < 0.0f)
+                step -= normal * into;
+        }
+    }
+
+    return position - center;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <functional>
+#include "meshBvh.h"
+
+// Distance kept between the mover and the surfaces it stops against, so the next frame
+// starts just outside them instead of exactly touching
+const float MOVE_AND_SLIDE_SKIN = 0.01f;
+
+// Closest surface within radius of the capsule around segment a-b, among everything the
+// mover can reach this move (MeshBvh::capsuleContact over each nearby object)
+typedef std::function<MeshContact(const glm::vec3& a, const glm::vec3& b, float radius)> CapsuleContactQuery;
+
+// Moves an upright capsule (axis center +- halfAxis on Y, then radius around it) by
+// displacement against real triangles. The move is cut into steps of at most half the
+// radius so thin walls are not skipped; after each step the capsule is pushed out of the
+// closest surface along the contact normal's horizontal part, and the rest of the step
+// loses its component into that surface (sliding along walls), up to four pushes a step.
+// Heights are left to the jump and ground code: floor and ceiling contacts do not push.
+// A push off a sloped triangle moves further than its depth, so the capsule's horizontal
+// travel is clamped to |displacement| + MOVE_AND_SLIDE_SKIN: the capsule never reaches
+// surfaces further than that from where it started, and a contact that needs more is left
+// for the next move to finish. Returns the displacement actually applied.
+glm::vec3 moveAndSlide(const glm::vec3& center, float halfAxis, float radius, const glm::vec3& displacement,
+    const CapsuleContactQuery& closestContact);
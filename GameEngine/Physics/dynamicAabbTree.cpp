@@ -0,0 +1,366 @@
+#include "dynamicAabbTree.h"
+#include <algorithm>
+#include <cmath>
+
+static Aabb combine(const Aabb& a, const Aabb& b)
+{
+    Aabb box = { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+    return box;
+}
+
+static bool contains(const Aabb& outer, const Aabb& inner)
+{
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+        inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+}
+
+// Box surface area halved, the insertion cost metric
+static float area(const Aabb& box)
+{
+    glm::vec3 d = box.max - box.min;
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+DynamicAabbTree::DynamicAabbTree(float margin)
+    : root(NULL_NODE), freeList(NULL_NODE), proxyCount(0), margin(margin)
+{
+}
+
+int DynamicAabbTree::allocateNode()
+{
+    if (freeList == NULL_NODE) {
+        nodes.push_back(Node());
+        freeList = static_cast<int>(nodes.size()) - 1;
+        nodes[freeList].parent = NULL_NODE;
+    }
+
+    int node = freeList;
+    freeList = nodes[node].parent;
+
+    nodes[node].parent = NULL_NODE;
+    nodes[node].child1 = NULL_NODE;
+    nodes[node].child2 = NULL_NODE;
+    nodes[node].height = 0;
+    nodes[node].userData = -1;
+    return node;
+}
+
+void DynamicAabbTree::freeNode(int node)
+{
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+int DynamicAabbTree::createProxy(const Aabb& box, int userData)
+{
+    int proxy = allocateNode();
+    nodes[proxy].box.min = box.min - glm::vec3(margin);
+    nodes[proxy].box.max = box.max + glm::vec3(margin);
+    nodes[proxy].userData = userData;
+
+    insertLeaf(proxy);
+    proxyCount++;
+    return proxy;
+}
+
+void DynamicAabbTree::destroyProxy(int proxy)
+{
+    removeLeaf(proxy);
+    freeNode(proxy);
+    proxyCount--;
+}
+
+bool DynamicAabbTree::moveProxy(int proxy, const Aabb& box, const glm::vec3& displacement)
+{
+    if (contains(nodes[proxy].box, box))
+        return false;
+
+    removeLeaf(proxy);
+
+    Aabb fat = { box.min - glm::vec3(margin), box.max + glm::vec3(margin) };
+    glm::vec3 stretch = displacement * 2.0f;
+    fat.min += glm::min(stretch, glm::vec3(0.0f));
+    fat.max += glm::max(stretch, glm::vec3(0.0f));
+    nodes[proxy].box = fat;
+
+    insertLeaf(proxy);
+    return true;
+}
+
+void DynamicAabbTree::insertLeaf(int leaf)
+{
+    if (root == NULL_NODE) {
+        root = leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    // Best-first branch and bound for the cheapest sibling: pairing with a node costs the
+    // area of the combined box, plus the growth of every ancestor above it (inherited cost).
+    // Nodes are expanded by lowest inherited cost, and the search stops once even the best
+    // case left cannot beat the best sibling found so far.
+    const Aabb leafBox = nodes[leaf].box;
+    const float leafArea = area(leafBox);
+
+    int index = root;
+    float bestCost = area(combine(nodes[root].box, leafBox));
+
+    candidates.clear();
+    candidates.push_back(Candidate(root, 0.0f));
+    while (!candidates.empty()) {
+        std::pop_heap(candidates.begin(), candidates.end());
+        Candidate candidate = candidates.back();
+        candidates.pop_back();
+        if (leafArea + candidate.inheritedCost >= bestCost)
+            break;
+
+        const Node& node = nodes[candidate.node];
+        float combinedArea = area(combine(node.box, leafBox));
+        float cost = combinedArea + candidate.inheritedCost;
+        if (cost < bestCost) {
+            bestCost = cost;
+            index = candidate.node;
+        }
+
+        if (node.isLeaf())
+            continue;
+
+        float childInheritedCost = candidate.inheritedCost + combinedArea - area(node.box);
+        if (leafArea + childInheritedCost < bestCost) {
+            candidates.push_back(Candidate(node.child1, childInheritedCost));
+            std::push_heap(candidates.begin(), candidates.end());
+            candidates.push_back(Candidate(node.child2, childInheritedCost));
+            std::push_heap(candidates.begin(), candidates.end());
+        }
+    }
+
+    int sibling = index;
+    int oldParent = nodes[sibling].parent;
+    int newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = combine(leafBox, nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == NULL_NODE)
+        root = newParent;
+    else if (nodes[oldParent].child1 == sibling)
+        nodes[oldParent].child1 = newParent;
+    else
+        nodes[oldParent].child2 = newParent;
+
+    refitAncestors(nodes[leaf].parent);
+}
+
+void DynamicAabbTree::removeLeaf(int leaf)
+{
+    if (leaf == root) {
+        root = NULL_NODE;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    // The sibling takes the parent's place
+    if (grandParent == NULL_NODE) {
+        root = sibling;
+        nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+        return;
+    }
+
+    if (nodes[grandParent].child1 == parent)
+        nodes[grandParent].child1 = sibling;
+    else
+        nodes[grandParent].child2 = sibling;
+    nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    refitAncestors(grandParent);
+}
+
+// Rebalances and refits every node from node up to the root
+void DynamicAabbTree::refitAncestors(int node)
+{
+    while (node != NULL_NODE) {
+        node = balance(node);
+
+        int child1 = nodes[node].child1;
+        int child2 = nodes[node].child2;
+        nodes[node].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[node].box = combine(nodes[child1].box, nodes[child2].box);
+
+        node = nodes[node].parent;
+    }
+}
+
+// If one child of a is two levels taller than the other, rotates the taller child up
+// into a's place. Returns the node now at a's position.
+int DynamicAabbTree::balance(int a)
+{
+    if (nodes[a].isLeaf())
+        return a;
+
+    int b = nodes[a].child1;
+    int c = nodes[a].child2;
+    int difference = nodes[c].height - nodes[b].height;
+
+    if (difference > 1 || difference < -1) {
+        // Make c the taller child, then lift it
+        bool cIsSecond = difference > 1;
+        if (!cIsSecond)
+            std::swap(b, c);
+
+        int f = nodes[c].child1;
+        int g = nodes[c].child2;
+
+        nodes[c].child1 = a;
+        nodes[c].parent = nodes[a].parent;
+        nodes[a].parent = c;
+
+        if (nodes[c].parent == NULL_NODE)
+            root = c;
+        else if (nodes[nodes[c].parent].child1 == a)
+            nodes[nodes[c].parent].child1 = c;
+        else
+            nodes[nodes[c].parent].child2 = c;
+
+        // c keeps its taller child, a takes the shorter one next to b
+        if (nodes[f].height < nodes[g].height)
+            std::swap(f, g);
+
+        nodes[c].child2 = f;
+        if (cIsSecond)
+            nodes[a].child2 = g;
+        else
+            nodes[a].child1 = g;
+        nodes[g].parent = a;
+
+        nodes[a].box = combine(nodes[b].box, nodes[g].box);
+        nodes[a].height = 1 + std::max(nodes[b].height, nodes[g].height);
+        nodes[c].box = combine(nodes[a].box, nodes[f].box);
+        nodes[c].height = 1 + std::max(nodes[a].height, nodes[f].height);
+        return c;
+    }
+
+    return a;
+}
+
+void DynamicAabbTree::query(const Aabb& box, std::vector<int>& results) const
+{
+    if (root == NULL_NODE)
+        return;
+
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        if (!node.box.overlaps(box))
+            continue;
+
+        if (node.isLeaf()) {
+            results.push_back(node.userData);
+        }
+        else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+void DynamicAabbTree::query(const Frustum& frustum, std::vector<int>& results) const
+{
+    if (root == NULL_NODE)
+        return;
+
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        if (!frustum.intersectsBox(node.box.min, node.box.max))
+            continue;
+
+        if (node.isLeaf()) {
+            results.push_back(node.userData);
+        }
+        else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+// Slab test against a node's box within [0, maxDistance]
+static bool rayHitsBox(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, const Aabb& box)
+{
+    glm::vec3 t0 = (box.min - origin) * inverseDirection;
+    glm::vec3 t1 = (box.max - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+    return enter <= exit;
+}
+
+void DynamicAabbTree::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<int>& results) const
+{
+    if (root == NULL_NODE)
+        return;
+
+    // Zero components become +-infinity, which the slab test handles
+    glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty()) {
+        const Node& node = nodes[stack.back()];
+        stack.pop_back();
+
+        if (!rayHitsBox(origin, inverseDirection, maxDistance, node.box))
+            continue;
+
+        if (node.isLeaf()) {
+            results.push_back(node.userData);
+        }
+        else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+bool DynamicAabbTree::validateNode(int index) const
+{
+    const Node& node = nodes[index];
+    if (node.isLeaf())
+        return node.height == 0 && node.child2 == NULL_NODE;
+
+    const Node& child1 = nodes[node.child1];
+    const Node& child2 = nodes[node.child2];
+    if (child1.parent != index || child2.parent != index)
+        return false;
+    if (node.height != 1 + std::max(child1.height, child2.height))
+        return false;
+    if (!contains(node.box, child1.box) || !contains(node.box, child2.box))
+        return false;
+
+    return validateNode(node.child1) && validateNode(node.child2);
+}
+
+bool DynamicAabbTree::validate() const
+{
+    if (root == NULL_NODE)
+        return proxyCount == 0;
+    return nodes[root].parent == NULL_NODE && validateNode(root);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+#include "aabb.h"
+#include "..\Camera\frustum.h"
+
+// Bounding volume hierarchy for objects that move, appear and disappear. Each object is a
+// leaf holding a "fat" box, its bounds grown by a margin, so small moves do not touch the
+// tree at all; larger ones remove and reinsert just that leaf. Inserts search for the
+// sibling that grows the total box area least, and AVL-style rotations keep the height
+// logarithmic, so overlap, frustum and ray queries visit O(log n) nodes plus the hits.
+class DynamicAabbTree
+{
+public:
+    explicit DynamicAabbTree(float margin = 1.0f);
+
+    // Returns a proxy id, stable until destroyProxy. userData is what queries report.
+    int createProxy(const Aabb& box, int userData);
+    void destroyProxy(int proxy);
+
+    // Updates a proxy's bounds after its object moved by displacement. The fat box is
+    // stretched along the displacement so steady motion keeps fitting. Returns true when
+    // the leaf had to be reinserted.
+    bool moveProxy(int proxy, const Aabb& box, const glm::vec3& displacement);
+
+    int getUserData(int proxy) const { return nodes[proxy].userData; }
+    const Aabb& getFatAabb(int proxy) const { return nodes[proxy].box; }
+
+    // Append the userData of every proxy whose fat box overlaps / is inside / is hit.
+    // Fat boxes are conservative: callers test the exact shape of each result.
+    void query(const Aabb& box, std::vector<int>& results) const;
+    void query(const Frustum& frustum, std::vector<int>& results) const;
+    void raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<int>& results) const;
+
+    int getProxyCount() const { return proxyCount; }
+    int getHeight() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+    // Checks parent links, heights and that every box encloses its children
+    bool validate() const;
+
+private:
+    static const int NULL_NODE = -1;
+
+    struct Node
+    {
+        Aabb box;
+        int parent;         // next free node while on the free list
+        int child1;
+        int child2;
+        int height;         // 0 for leaves, -1 for free nodes
+        int userData;
+
+        bool isLeaf() const { return child1 == NULL_NODE; }
+    };
+
+    int allocateNode();
+    void freeNode(int node);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int balance(int node);
+    void refitAncestors(int node);
+    bool validateNode(int node) const;
+
+    std::vector<Node> nodes;
+    int root;
+    int freeList;
+    int proxyCount;
+    float margin;
+
+    struct Candidate
+    {
+        int node;
+        float inheritedCost;
+
+        Candidate(int node, float inheritedCost) : node(node), inheritedCost(inheritedCost) {}
+
+        // Heap order: lowest inherited cost on top
+        bool operator<(const Candidate& other) const { return inheritedCost > other.inheritedCost; }
+    };
+
+    std::vector<Candidate> candidates;  // insertion scratch, a heap
+    mutable std::vector<int> stack;     // traversal scratch, queries are not reentrant
+};
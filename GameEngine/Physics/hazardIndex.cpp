@@ -0,0 +1,127 @@
+#include "hazardIndex.h"
+#include "..\Utils\threadPool.h"
+#include <algorithm>
+#include <cmath>
+
+// Sparse maps get larger cells rather than huge offset tables
+static const int HAZARD_INDEX_MAX_CELLS_PER_SIDE = 1024;
+
+HazardIndex::HazardIndex()
+    : origin(0.0f), cellSize(1.0f), inverseCellSize(1.0f), cellsX(0), cellsZ(0)
+{
+}
+
+void HazardIndex::build(const std::vector<HazardZone>& zones)
+{
+    discs.resize(zones.size());
+    cellStart.clear();
+    cellZones.clear();
+    cellsX = cellsZ = 0;
+
+    glm::vec2 lo(0.0f), hi(0.0f);
+    float diameterSum = 0.0f;
+    int covering = 0;
+    for (size_t i = 0; i < zones.size(); ++i) {
+        float radius = zones[i].size.x * 0.5f;
+        discs[i].x = zones[i].position.x;
+        discs[i].z = zones[i].position.z;
+        discs[i].radiusSquared = radius * radius;
+
+        // Discs with no positive radius contain nothing and stay out of the grid
+        if (!(radius > 0.0f))
+            continue;
+
+        glm::vec2 center(discs[i].x, discs[i].z);
+        lo = covering == 0 ? center - radius : glm::min(lo, center - radius);
+        hi = covering == 0 ? center + radius : glm::max(hi, center + radius);
+        diameterSum += 2.0f * radius;
+        covering++;
+    }
+    if (covering == 0)
+        return;
+
+    glm::vec2 extent = hi - lo;
+    cellSize = std::max(diameterSum / covering, std::max(extent.x, extent.y) / HAZARD_INDEX_MAX_CELLS_PER_SIDE);
+    inverseCellSize = 1.0f / cellSize;
+    origin = lo;
+    cellsX = std::max(1, static_cast<int>(std::ceil(extent.x * inverseCellSize)));
+    cellsZ = std::max(1, static_cast<int>(std::ceil(extent.y * inverseCellSize)));
+    cellsX = std::min(cellsX, HAZARD_INDEX_MAX_CELLS_PER_SIDE);
+    cellsZ = std::min(cellsZ, HAZARD_INDEX_MAX_CELLS_PER_SIDE);
+
+    // Cell range under each disc's bounding square, clamped to the grid
+    auto cellRange = [&](int id, int& x0, int& x1, int& z0, int& z1) {
+        float radius = zones[id].size.x * 0.5f;
+        x0 = std::max(0, static_cast<int>(std::floor((discs[id].x - radius - origin.x) * inverseCellSize)));
+        x1 = std::min(cellsX - 1, static_cast<int>(std::floor((discs[id].x + radius - origin.x) * inverseCellSize)));
+        z0 = std::max(0, static_cast<int>(std::floor((discs[id].z - radius - origin.y) * inverseCellSize)));
+        z1 = std::min(cellsZ - 1, static_cast<int>(std::floor((discs[id].z + radius - origin.y) * inverseCellSize)));
+    };
+
+    // Count, prefix-sum, then scatter in id order so every cell lists its zones ascending
+    cellStart.assign(static_cast<size_t>(cellsX) * cellsZ + 1, 0);
+    for (int id = 0; id < static_cast<int>(zones.size()); ++id) {
+        if (!(zones[id].size.x > 0.0f))
+            continue;
+        int x0, x1, z0, z1;
+        cellRange(id, x0, x1, z0, z1);
+        for (int z = z0; z <= z1; ++z)
+            for (int x = x0; x <= x1; ++x)
+                cellStart[z * cellsX + x + 1]++;
+    }
+    for (size_t i = 1; i < cellStart.size(); ++i)
+        cellStart[i] += cellStart[i - 1];
+
+    cellZones.resize(cellStart.back());
+    std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (int id = 0; id < static_cast<int>(zones.size()); ++id) {
+        if (!(zones[id].size.x > 0.0f))
+            continue;
+        int x0, x1, z0, z1;
+        cellRange(id, x0, x1, z0, z1);
+        for (int z = z0; z <= z1; ++z)
+            for (int x = x0; x <= x1; ++x)
+                cellZones[fill[z * cellsX + x]++] = id;
+    }
+}
+
+int HazardIndex::find(const glm::vec3& point) const
+{
+    if (cellsX == 0)
+        return -1;
+
+    // Points a cell or more off the grid are outside every disc (the compare also rejects
+    // NaN); nearer ones are clamped exactly like the disc bounds were when bucketing
+    float fx = std::floor((point.x - origin.x) * inverseCellSize);
+    float fz = std::floor((point.z - origin.y) * inverseCellSize);
+    if (!(fx >= -1.0f && fz >= -1.0f && fx <= static_cast<float>(cellsX) && fz <= static_cast<float>(cellsZ)))
+        return -1;
+
+    int x = std::min(std::max(static_cast<int>(fx), 0), cellsX - 1);
+    int z = std::min(std::max(static_cast<int>(fz), 0), cellsZ - 1);
+    int cell = z * cellsX + x;
+    for (int i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+        const Disc& disc = discs[cellZones[i]];
+        float dx = point.x - disc.x;
+        float dz = point.z - disc.z;
+        if (dx * dx + dz * dz < disc.radiusSquared)
+            return cellZones[i];
+    }
+    return -1;
+}
+
+void HazardIndex::find(const glm::vec3* points, int count, int* results) const
+{
+    const int bandSize = 4096;
+
+    if (count <= bandSize) {
+        for (int i = 0; i < count; ++i)
+            results[i] = find(points[i]);
+        return;
+    }
+
+    ThreadPool::shared().parallelFor(0, count, bandSize, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+            results[i] = find(points[i]);
+    });
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glm.hpp>
+#include <string>
+#include <vector>
+
+// Structure representing a hazard zone
+struct HazardZone {
+    glm::vec3 position;
+    glm::vec3 size;
+    int damage;
+    std::string name;
+};
+
+// A zone covers the open disc of radius size.x / 2 around its position in XZ, the shape
+// the terrain carves and the fragment shader darkens
+inline bool hazardContainsPoint(const HazardZone& zone, float x, float z)
+{
+    float radius = zone.size.x * 0.5f;
+    float dx = x - zone.position.x;
+    float dz = z - zone.position.z;
+    return dx * dx + dz * dz < radius * radius;
+}
+
+// Uniform grid over the XZ plane answering "which hazard contains this point". Cells are
+// about as wide as an average zone, so a point only tests the few zones whose bounding
+// squares cover its cell: lookups take constant time however many zones there are.
+// Cells are one flat zone array indexed by per-cell offsets (built with a counting pass).
+class HazardIndex
+{
+public:
+    HazardIndex();
+
+    // Rebuilds the grid over zones; ids reported by find() are indices into zones
+    void build(const std::vector<HazardZone>& zones);
+
+    // First zone (lowest index) whose disc contains point's XZ, -1 when there is none
+    int find(const glm::vec3& point) const;
+
+    // find() for count points at once, e.g. every agent in a frame. Large batches are
+    // split over the shared thread pool.
+    void find(const glm::vec3* points, int count, int* results) const;
+
+    int getZoneCount() const { return static_cast<int>(discs.size()); }
+    int getCellCount() const { return cellsX * cellsZ; }
+    float getCellSize() const { return cellSize; }
+
+    // The grid itself, for copies that answer the same query elsewhere (the fragment
+    // shader): cell (x, z) lists cellZones[cellStart[c] .. cellStart[c + 1]) with
+    // c = z * cellsX + x. Both arrays are empty when no zone has a positive radius.
+    glm::vec2 getOrigin() const { return origin; }
+    int getCellsX() const { return cellsX; }
+    int getCellsZ() const { return cellsZ; }
+    const std::vector<int>& getCellStart() const { return cellStart; }
+    const std::vector<int>& getCellZones() const { return cellZones; }
+
+private:
+    struct Disc
+    {
+        float x;
+        float z;
+        float radiusSquared;
+    };
+
+    std::vector<Disc> discs;
+    std::vector<int> cellStart;     // cellsX * cellsZ + 1 offsets into cellZones
+    std::vector<int> cellZones;     // ascending zone ids per cell
+    glm::vec2 origin;               // XZ of the grid's min corner
+    float cellSize;
+    float inverseCellSize;
+    int cellsX;
+    int cellsZ;
+};
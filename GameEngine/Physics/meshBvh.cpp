@@ -0,0 +1,559 @@
+#include "meshBvh.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+static Aabb emptyBox()
+{
+    Aabb box = { glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX) };
+    return box;
+}
+
+static void growBox(Aabb& box, const Aabb& other)
+{
+    box.min = glm::min(box.min, other.min);
+    box.max = glm::max(box.max, other.max);
+}
+
+static float surfaceArea(const Aabb& box)
+{
+    glm::vec3 size = glm::max(box.max - box.min, glm::vec3(0.0f));
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+// ---------- INSTANCE TRANSFORM ----------
+
+// The instance's rotation as the unit vectors its local axes map to, like Obb::fromTransform
+struct InstanceFrame
+{
+    glm::vec3 axes[3];
+    glm::vec3 position;
+    glm::vec3 scale;
+
+    explicit InstanceFrame(const MeshTransform& transform)
+    {
+        float angle = transform.rotationY * 3.14159265f / 180.0f;
+        float c = std::cos(angle);
+        float s = std::sin(angle);
+        axes[0] = glm::vec3(c, 0.0f, -s);
+        axes[1] = glm::vec3(0.0f, 1.0f, 0.0f);
+        axes[2] = glm::vec3(s, 0.0f, c);
+        position = transform.position;
+        scale = transform.scale;
+    }
+
+    glm::vec3 toWorld(const glm::vec3& p) const
+    {
+        return position + axes[0] * (p.x * scale.x) + axes[1] * (p.y * scale.y) + axes[2] * (p.z * scale.z);
+    }
+
+    glm::vec3 vectorToLocal(const glm::vec3& v) const
+    {
+        return glm::vec3(glm::dot(axes[0], v) / scale.x, glm::dot(axes[1], v) / scale.y, glm::dot(axes[2], v) / scale.z);
+    }
+
+    glm::vec3 toLocal(const glm::vec3& p) const
+    {
+        return vectorToLocal(p - position);
+    }
+
+    // Normals go through the inverse transpose: rotate(n / scale)
+    glm::vec3 normalToWorld(const glm::vec3& n) const
+    {
+        return glm::normalize(axes[0] * (n.x / scale.x) + axes[1] * (n.y / scale.y) + axes[2] * (n.z / scale.z));
+    }
+};
+
+// ---------- BUILD ----------
+
+MeshBvh::MeshBvh()
+    : depth(0)
+{
+}
+
+MeshBvh::MeshBvh(const Mesh& mesh)
+    : depth(0)
+{
+    build(mesh.vertices, mesh.indices);
+}
+
+MeshBvh::MeshBvh(const std::vector<Vertex>& vertices, const std::vector<int>& indices)
+    : depth(0)
+{
+    build(vertices, indices);
+}
+
+void MeshBvh::build(const std::vector<Vertex>& vertices, const std::vector<int>& indices)
+{
+    int triangleCount = static_cast<int>(indices.size() / 3);
+    nodes.clear();
+    corners.clear();
+    depth = 0;
+    if (triangleCount == 0)
+        return;
+
+    std::vector<Aabb> triangleBoxes(triangleCount);
+    std::vector<glm::vec3> centroids(triangleCount);
+    std::vector<int> order(triangleCount);
+    for (int i = 0; i < triangleCount; ++i) {
+        const glm::vec3& a = vertices[indices[i * 3]].pos;
+        const glm::vec3& b = vertices[indices[i * 3 + 1]].pos;
+        const glm::vec3& c = vertices[indices[i * 3 + 2]].pos;
+        triangleBoxes[i].min = glm::min(a, glm::min(b, c));
+        triangleBoxes[i].max = glm::max(a, glm::max(b, c));
+        centroids[i] = (triangleBoxes[i].min + triangleBoxes[i].max) * 0.5f;
+        order[i] = i;
+    }
+
+    nodes.reserve(2 * (triangleCount / LEAF_SIZE + 1));
+    nodes.push_back(Node());
+    split(0, order, triangleBoxes, centroids, 0, triangleCount, 1);
+
+    // Leaves address [first, first + count) of order, copy their corners in that order
+    corners.resize(static_cast<size_t>(triangleCount) * 3);
+    for (int i = 0; i < triangleCount; ++i)
+        for (int k = 0; k < 3; ++k)
+            corners[i * 3 + k] = vertices[indices[order[i] * 3 + k]].pos;
+}
+
+void MeshBvh::split(int nodeIndex, std::vector<int>& order, const std::vector<Aabb>& triangleBoxes,
+    const std::vector<glm::vec3>& centroids, int begin, int end, int level)
+{
+    const int BIN_COUNT = 12;
+
+    depth = std::max(depth, level);
+
+    Aabb box = emptyBox();
+    Aabb centroidBox = emptyBox();
+    for (int i = begin; i < end; ++i) {
+        growBox(box, triangleBoxes[order[i]]);
+        centroidBox.min = glm::min(centroidBox.min, centroids[order[i]]);
+        centroidBox.max = glm::max(centroidBox.max, centroids[order[i]]);
+    }
+    nodes[nodeIndex].box = box;
+    nodes[nodeIndex].first = begin;
+    nodes[nodeIndex].count = end - begin;
+
+    int count = end - begin;
+    if (count <= LEAF_SIZE)
+        return;
+
+    glm::vec3 extent = centroidBox.max - centroidBox.min;
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+    if (extent[axis] <= 0.0f)
+        return;     // every centroid in one spot, no split can separate them
+
+    // Bin the centroids along the widest axis and price every bin boundary as
+    // area(left) * count(left) + area(right) * count(right)
+    Aabb binBoxes[BIN_COUNT];
+    int binCounts[BIN_COUNT] = {};
+    for (int b = 0; b < BIN_COUNT; ++b)
+        binBoxes[b] = emptyBox();
+
+    float binScale = BIN_COUNT / extent[axis];
+    for (int i = begin; i < end; ++i) {
+        int b = std::min(BIN_COUNT - 1, static_cast<int>((centroids[order[i]][axis] - centroidBox.min[axis]) * binScale));
+        binCounts[b]++;
+        growBox(binBoxes[b], triangleBoxes[order[i]]);
+    }
+
+    float rightCosts[BIN_COUNT];
+    Aabb accumulated = emptyBox();
+    int accumulatedCount = 0;
+    for (int b = BIN_COUNT - 1; b > 0; --b) {
+        growBox(accumulated, binBoxes[b]);
+        accumulatedCount += binCounts[b];
+        rightCosts[b] = accumulatedCount > 0 ? surfaceArea(accumulated) * accumulatedCount : 0.0f;
+    }
+
+    int bestSplit = -1;
+    float bestCost = FLT_MAX;
+    accumulated = emptyBox();
+    accumulatedCount = 0;
+    for (int b = 0; b < BIN_COUNT - 1; ++b) {
+        growBox(accumulated, binBoxes[b]);
+        accumulatedCount += binCounts[b];
+        if (accumulatedCount == 0 || accumulatedCount == count)
+            continue;
+        float cost = surfaceArea(accumulated) * accumulatedCount + rightCosts[b + 1];
+        if (cost < bestCost) {
+            bestCost = cost;
+            bestSplit = b;
+        }
+    }
+
+    // Small nodes stay leaves when no split is cheaper than testing every triangle
+    if (bestSplit < 0 || (count <= 4 * LEAF_SIZE && bestCost >= surfaceArea(box) * count))
+        return;
+
+    int mid;
+    if (level < MAX_SAH_DEPTH) {
+        int* middle = std::partition(&order[0] + begin, &order[0] + end, [&](int triangle) {
+            int b = std::min(BIN_COUNT - 1, static_cast<int>((centroids[triangle][axis] - centroidBox.min[axis]) * binScale));
+            return b <= bestSplit;
+        });
+        mid = static_cast<int>(middle - &order[0]);
+    }
+    else {
+        // Lopsided SAH splits could grow the tree past the query stacks, halve the rest
+        mid = begin + count / 2;
+        std::nth_element(&order[0] + begin, &order[0] + mid, &order[0] + end, [&](int left, int right) {
+            return centroids[left][axis] < centroids[right][axis];
+        });
+    }
+
+    int left = static_cast<int>(nodes.size());
+    nodes.push_back(Node());
+    nodes.push_back(Node());
+    nodes[nodeIndex].first = left;
+    nodes[nodeIndex].count = 0;
+
+    split(left, order, triangleBoxes, centroids, begin, mid, level + 1);
+    split(left + 1, order, triangleBoxes, centroids, mid, end, level + 1);
+}
+
+Aabb MeshBvh::getBounds() const
+{
+    if (nodes.empty())
+        return Aabb::fromCenter(glm::vec3(0.0f), glm::vec3(0.0f));
+    return nodes[0].box;
+}
+
+// ---------- RAY QUERIES ----------
+
+// Entry distance of the ray into box within [0, maxDistance], or FLT_MAX on a miss
+static float rayEnterBox(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, const Aabb& box)
+{
+    glm::vec3 t0 = (box.min - origin) * inverseDirection;
+    glm::vec3 t1 = (box.max - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+    return enter <= exit ? enter : FLT_MAX;
+}
+
+bool intersectRayTriangle(const glm::vec3& origin, const glm::vec3& direction,
+    const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float& t)
+{
+    glm::vec3 edge1 = b - a;
+    glm::vec3 edge2 = c - a;
+    glm::vec3 p = glm::cross(direction, edge2);
+    float determinant = glm::dot(edge1, p);
+    if (std::fabs(determinant) < 1e-12f)
+        return false;
+
+    float inverse = 1.0f / determinant;
+    glm::vec3 s = origin - a;
+    float u = glm::dot(s, p) * inverse;
+    if (u < 0.0f || u > 1.0f)
+        return false;
+
+    glm::vec3 q = glm::cross(s, edge1);
+    float v = glm::dot(direction, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+
+    t = glm::dot(edge2, q) * inverse;
+    return t >= 0.0f;
+}
+
+MeshRayHit MeshBvh::raycast(const MeshTransform& transform, const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+{
+    MeshRayHit result;
+    result.hit = false;
+    result.distance = maxDistance;
+    if (nodes.empty())
+        return result;
+
+    // Mapped without renormalizing, so local t is still the world distance
+    InstanceFrame frame(transform);
+    glm::vec3 localOrigin = frame.toLocal(origin);
+    glm::vec3 localDirection = frame.vectorToLocal(direction);
+    glm::vec3 inverseDirection(1.0f / localDirection.x, 1.0f / localDirection.y, 1.0f / localDirection.z);
+
+    int hitTriangle = -1;
+    float best = maxDistance;
+
+    int stack[MAX_DEPTH];
+    int stackSize = 0;
+    if (rayEnterBox(localOrigin, inverseDirection, best, nodes[0].box) != FLT_MAX)
+        stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const Node& node = nodes[stack[--stackSize]];
+
+        if (node.count > 0) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                float t;
+                if (intersectRayTriangle(localOrigin, localDirection, corners[i * 3], corners[i * 3 + 1], corners[i * 3 + 2], t) && t <= best) {
+                    best = t;
+                    hitTriangle = i;
+                }
+            }
+            continue;
+        }
+
+        // Nearer child on top of the stack, children behind the best hit are skipped
+        float enterLeft = rayEnterBox(localOrigin, inverseDirection, best, nodes[node.first].box);
+        float enterRight = rayEnterBox(localOrigin, inverseDirection, best, nodes[node.first + 1].box);
+        int nearChild = node.first, farChild = node.first + 1;
+        if (enterRight < enterLeft) {
+            std::swap(enterLeft, enterRight);
+            std::swap(nearChild, farChild);
+        }
+        if (enterRight != FLT_MAX)
+            stack[stackSize++] = farChild;
+        if (enterLeft != FLT_MAX)
+            stack[stackSize++] = nearChild;
+    }
+
+    if (hitTriangle < 0)
+        return result;
+
+    const glm::vec3* triangle = &corners[hitTriangle * 3];
+    glm::vec3 normal = frame.normalToWorld(glm::cross(triangle[1] - triangle[0], triangle[2] - triangle[0]));
+    if (glm::dot(normal, direction) > 0.0f)
+        normal = -normal;
+
+    result.hit = true;
+    result.distance = best;
+    result.position = origin + direction * best;
+    result.normal = normal;
+    return result;
+}
+
+// ---------- CAPSULE QUERIES ----------
+
+// Closest point to p on triangle abc, by the Voronoi region p falls in
+static glm::vec3 closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    float denominator = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+// Closest points between segments p1-q1 and p2-q2, squared distance between them
+static float closestSegmentSegment(const glm::vec3& p1, const glm::vec3& q1, const glm::vec3& p2, const glm::vec3& q2,
+    glm::vec3& c1, glm::vec3& c2)
+{
+    glm::vec3 d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+    float a = glm::dot(d1, d1), e = glm::dot(d2, d2), f = glm::dot(d2, r);
+    float s = 0.0f, t = 0.0f;
+
+    if (a <= 1e-12f && e <= 1e-12f) {
+        // both degenerate to points
+    }
+    else if (a <= 1e-12f) {
+        t = glm::clamp(f / e, 0.0f, 1.0f);
+    }
+    else {
+        float c = glm::dot(d1, r);
+        if (e <= 1e-12f) {
+            s = glm::clamp(-c / a, 0.0f, 1.0f);
+        }
+        else {
+            float b = glm::dot(d1, d2);
+            float denominator = a * e - b * b;
+            s = denominator > 0.0f ? glm::clamp((b * f - c * e) / denominator, 0.0f, 1.0f) : 0.0f;
+            t = (b * s + f) / e;
+            if (t < 0.0f) {
+                t = 0.0f;
+                s = glm::clamp(-c / a, 0.0f, 1.0f);
+            }
+            else if (t > 1.0f) {
+                t = 1.0f;
+                s = glm::clamp((b - c) / a, 0.0f, 1.0f);
+            }
+        }
+    }
+
+    c1 = p1 + d1 * s;
+    c2 = p2 + d2 * t;
+    glm::vec3 between = c1 - c2;
+    return glm::dot(between, between);
+}
+
+float segmentTriangleDistance(const glm::vec3& p, const glm::vec3& q,
+    const glm::vec3& a, const glm::vec3& b, const glm::vec3& c,
+    glm::vec3& onSegment, glm::vec3& onTriangle)
+{
+    // A segment through the triangle touches it at the crossing
+    float t;
+    if (intersectRayTriangle(p, q - p, a, b, c, t) && t <= 1.0f) {
+        onSegment = onTriangle = p + (q - p) * t;
+        return 0.0f;
+    }
+
+    // Otherwise the closest pair has an endpoint of the segment or lies on an edge
+    onSegment = p;
+    onTriangle = closestPointOnTriangle(p, a, b, c);
+    float best = glm::dot(p - onTriangle, p - onTriangle);
+
+    glm::vec3 candidate = closestPointOnTriangle(q, a, b, c);
+    float distance = glm::dot(q - candidate, q - candidate);
+    if (distance < best) {
+        best = distance;
+        onSegment = q;
+        onTriangle = candidate;
+    }
+
+    const glm::vec3* edges[3][2] = { { &a, &b }, { &b, &c }, { &c, &a } };
+    for (int i = 0; i < 3; ++i) {
+        glm::vec3 s, e;
+        distance = closestSegmentSegment(p, q, *edges[i][0], *edges[i][1], s, e);
+        if (distance < best) {
+            best = distance;
+            onSegment = s;
+            onTriangle = e;
+        }
+    }
+
+    return std::sqrt(best);
+}
+
+// Whether segment p-q passes through box grown by radius on every side; the grown box
+// encloses every point within radius of the box, so this never rejects a touching capsule
+static bool segmentNearBox(const glm::vec3& p, const glm::vec3& q, float radius, const Aabb& box)
+{
+    glm::vec3 lo = box.min - glm::vec3(radius);
+    glm::vec3 hi = box.max + glm::vec3(radius);
+    glm::vec3 d = q - p;
+
+    float enter = 0.0f, exit = 1.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (std::fabs(d[axis]) < 1e-12f) {
+            if (p[axis] < lo[axis] || p[axis] > hi[axis])
+                return false;
+            continue;
+        }
+        float inverse = 1.0f / d[axis];
+        float t0 = (lo[axis] - p[axis]) * inverse;
+        float t1 = (hi[axis] - p[axis]) * inverse;
+        enter = std::max(enter, std::min(t0, t1));
+        exit = std::min(exit, std::max(t0, t1));
+        if (enter > exit)
+            return false;
+    }
+    return true;
+}
+
+// Squared distance from p to the nearest point of box
+static float pointBoxDistanceSquared(const glm::vec3& p, const Aabb& box)
+{
+    glm::vec3 outside = glm::max(box.min - p, glm::max(p - box.max, glm::vec3(0.0f)));
+    return glm::dot(outside, outside);
+}
+
+MeshContact MeshBvh::capsuleContact(const MeshTransform& transform, const glm::vec3& a, const glm::vec3& b, float radius) const
+{
+    MeshContact result;
+    result.hit = false;
+    result.distance = radius;
+    if (nodes.empty())
+        return result;
+
+    // The world ball of radius r fits in a local ball of radius r / (smallest scale)
+    InstanceFrame frame(transform);
+    glm::vec3 localA = frame.toLocal(a);
+    glm::vec3 localB = frame.toLocal(b);
+    glm::vec3 localMiddle = (localA + localB) * 0.5f;
+    glm::vec3 absScale = glm::abs(transform.scale);
+    float localPerWorld = 1.0f / std::min(absScale.x, std::min(absScale.y, absScale.z));
+
+    float best = radius;
+    glm::vec3 bestOnSegment, bestOnTriangle, bestCorners[3];
+
+    int stack[MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    // Closer nodes first shrink best early, nothing beats an axis through the mesh
+    while (stackSize > 0 && !(result.hit && best == 0.0f)) {
+        const Node& node = nodes[stack[--stackSize]];
+        if (!segmentNearBox(localA, localB, best * localPerWorld, node.box))
+            continue;
+
+        if (node.count == 0) {
+            int nearChild = node.first, farChild = node.first + 1;
+            if (pointBoxDistanceSquared(localMiddle, nodes[farChild].box) < pointBoxDistanceSquared(localMiddle, nodes[nearChild].box))
+                std::swap(nearChild, farChild);
+            stack[stackSize++] = farChild;
+            stack[stackSize++] = nearChild;
+            continue;
+        }
+
+        for (int i = node.first; i < node.first + node.count; ++i) {
+            glm::vec3 p0 = frame.toWorld(corners[i * 3]);
+            glm::vec3 p1 = frame.toWorld(corners[i * 3 + 1]);
+            glm::vec3 p2 = frame.toWorld(corners[i * 3 + 2]);
+
+            Aabb triangleBox = { glm::min(p0, glm::min(p1, p2)), glm::max(p0, glm::max(p1, p2)) };
+            if (!segmentNearBox(a, b, best, triangleBox))
+                continue;
+
+            glm::vec3 onSegment, onTriangle;
+            float distance = segmentTriangleDistance(a, b, p0, p1, p2, onSegment, onTriangle);
+            if (distance > best)
+                continue;
+
+            best = distance;
+            bestOnSegment = onSegment;
+            bestOnTriangle = onTriangle;
+            bestCorners[0] = p0;
+            bestCorners[1] = p1;
+            bestCorners[2] = p2;
+            result.hit = true;
+        }
+    }
+
+    if (!result.hit)
+        return result;
+
+    // Where the axis crosses the triangle the face normal, turned toward a, separates them
+    glm::vec3 normal;
+    if (best > 1e-6f) {
+        normal = (bestOnSegment - bestOnTriangle) / best;
+    }
+    else {
+        normal = glm::cross(bestCorners[1] - bestCorners[0], bestCorners[2] - bestCorners[0]);
+        float length = glm::length(normal);
+        normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+        if (glm::dot(normal, a - bestOnTriangle) < 0.0f)
+            normal = -normal;
+    }
+
+    result.distance = best;
+    result.point = bestOnTriangle;
+    result.normal = normal;
+    return result;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include "aabb.h"
+#include "..\Model Loading\mesh.h"
+
+// Where an instance of a mesh is drawn, as the renderer places it:
+// translate(position) * rotate(rotationY degrees about Y) * scale(scale)
+struct MeshTransform
+{
+    glm::vec3 position;
+    glm::vec3 scale;
+    float rotationY;
+};
+
+struct MeshRayHit
+{
+    bool hit;
+    float distance;         // along the ray, in world units
+    glm::vec3 position;
+    glm::vec3 normal;       // unit face normal, facing the ray origin
+};
+
+struct MeshContact
+{
+    bool hit;
+    float distance;         // from the capsule's axis to the mesh, 0 when the axis crosses it
+    glm::vec3 point;        // closest point on the mesh
+    glm::vec3 normal;       // unit direction from point toward the capsule's axis
+};
+
+// Bounding volume hierarchy over one mesh's triangles, kept in the mesh's local space.
+// It is built once per mesh and shared by every instance of it: world-space queries are
+// carried into the instance's local space, so instances cost nothing to place or move.
+// Nodes are split by a binned surface area heuristic and stored depth-first with both
+// children side by side; leaves hold copies of their triangles' corners, so a query
+// reads the tree and the triangles it reaches in order and never touches the mesh.
+class MeshBvh
+{
+public:
+    MeshBvh();
+    explicit MeshBvh(const Mesh& mesh);
+    MeshBvh(const std::vector<Vertex>& vertices, const std::vector<int>& indices);
+
+    // Nearest triangle (either side) hit by the ray; direction must be unit length
+    MeshRayHit raycast(const MeshTransform& transform, const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const;
+
+    // Closest triangle to the capsule around segment a-b, when it is within radius.
+    // Non-uniform scales are handled exactly: the tree is culled with a local capsule
+    // that encloses the world one, candidate triangles are measured in world space.
+    MeshContact capsuleContact(const MeshTransform& transform, const glm::vec3& a, const glm::vec3& b, float radius) const;
+
+    int getTriangleCount() const { return static_cast<int>(corners.size() / 3); }
+    int getNodeCount() const { return static_cast<int>(nodes.size()); }
+    int getDepth() const { return depth; }
+    Aabb getBounds() const;
+
+private:
+    static const int LEAF_SIZE = 4;
+    static const int MAX_SAH_DEPTH = 32;    // deeper nodes split at the median, so depth stays under MAX_DEPTH
+    static const int MAX_DEPTH = 64;
+
+    struct Node
+    {
+        Aabb box;
+        int first;          // leaves: first triangle; interior nodes: left child, right is first + 1
+        int count;          // triangles in a leaf, 0 for interior nodes
+    };
+
+    void build(const std::vector<Vertex>& vertices, const std::vector<int>& indices);
+    void split(int node, std::vector<int>& order, const std::vector<Aabb>& triangleBoxes,
+        const std::vector<glm::vec3>& centroids, int begin, int end, int level);
+
+    std::vector<Node> nodes;
+    std::vector<glm::vec3> corners;     // three per triangle, in leaf order
+    int depth;
+};
+
+// Two-sided ray/triangle test; t is along direction, which need not be unit length
+bool intersectRayTriangle(const glm::vec3& origin, const glm::vec3& direction,
+    const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float& t);
+
+// Distance between segment p-q and triangle abc, with the closest point on each
+float segmentTriangleDistance(const glm::vec3& p, const glm::vec3& q,
+    const glm::vec3& a, const glm::vec3& b, const glm::vec3& c,
+    glm::vec3& onSegment, glm::vec3& onTriangle);
@@ -0,0 +1,71 @@
+#include "obb.h"
+#include <cmath>
+
+Obb Obb::fromTransform(const Aabb& localBounds, const glm::vec3& position, const glm::vec3& scale, float rotationY)
+{
+    float angle = rotationY * 3.14159265f / 180.0f;
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+
+    // Columns of the Y rotation, as glm::rotate builds it
+    Obb obb;
+    obb.axes[0] = glm::vec3(c, 0.0f, -s);
+    obb.axes[1] = glm::vec3(0.0f, 1.0f, 0.0f);
+    obb.axes[2] = glm::vec3(s, 0.0f, c);
+
+    glm::vec3 localCenter = (localBounds.min + localBounds.max) * 0.5f * scale;
+    obb.center = position + obb.axes[0] * localCenter.x + obb.axes[1] * localCenter.y + obb.axes[2] * localCenter.z;
+    obb.halfExtents = glm::abs((localBounds.max - localBounds.min) * 0.5f * scale);
+    return obb;
+}
+
+Aabb Obb::getBounds() const
+{
+    glm::vec3 extent(
+        getProjectedRadius(glm::vec3(1.0f, 0.0f, 0.0f)),
+        getProjectedRadius(glm::vec3(0.0f, 1.0f, 0.0f)),
+        getProjectedRadius(glm::vec3(0.0f, 0.0f, 1.0f)));
+
+    Aabb box = { center - extent, center + extent };
+    return box;
+}
+
+float Obb::getProjectedRadius(const glm::vec3& axis) const
+{
+    return std::fabs(glm::dot(axes[0], axis)) * halfExtents.x +
+        std::fabs(glm::dot(axes[1], axis)) * halfExtents.y +
+        std::fabs(glm::dot(axes[2], axis)) * halfExtents.z;
+}
+
+bool Obb::overlaps(const Aabb& box) const
+{
+    const glm::vec3 world[3] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+    const glm::vec3 boxCenter = (box.min + box.max) * 0.5f;
+    const glm::vec3 boxHalf = (box.max - box.min) * 0.5f;
+    const glm::vec3 offset = center - boxCenter;
+
+    // Both sets of face normals, then the nine edge crossings; near-parallel crossings
+    // repeat a face axis and are skipped
+    glm::vec3 candidates[15];
+    int count = 0;
+    for (int i = 0; i < 3; ++i) {
+        candidates[count++] = world[i];
+        candidates[count++] = axes[i];
+    }
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            glm::vec3 axis = glm::cross(world[i], axes[j]);
+            float length = glm::length(axis);
+            if (length > 1e-4f)
+                candidates[count++] = axis / length;
+        }
+    }
+
+    for (int i = 0; i < count; ++i) {
+        const glm::vec3& axis = candidates[i];
+        float boxRadius = std::fabs(axis.x) * boxHalf.x + std::fabs(axis.y) * boxHalf.y + std::fabs(axis.z) * boxHalf.z;
+        if (std::fabs(glm::dot(offset, axis)) > boxRadius + getProjectedRadius(axis))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "aabb.h"
+
+// Oriented box: center, three orthonormal axes and the half extent along each
+struct Obb
+{
+    glm::vec3 center;
+    glm::vec3 axes[3];
+    glm::vec3 halfExtents;
+
+    // A mesh's local bounds placed like the renderer places the mesh:
+    // translate(position) * rotate(rotationY degrees about Y) * scale(scale)
+    static Obb fromTransform(const Aabb& localBounds, const glm::vec3& position, const glm::vec3& scale, float rotationY);
+
+    // Smallest enclosing axis-aligned box
+    Aabb getBounds() const;
+
+    // Half length of the box's projection onto a unit axis
+    float getProjectedRadius(const glm::vec3& axis) const;
+
+    // Separating-axis test against an axis-aligned box (touching boxes overlap)
+    bool overlaps(const Aabb& box) const;
+};
@@ -0,0 +1,63 @@
+#version 400
+
+// No vertex attributes: gl_VertexID = z * clipmapSize + x inside the clipmap ring
+
+out vec2 textureCoord;
+out vec3 norm;
+out vec3 fragPos;
+out vec2 worldPosXZ;
+
+// Per-frame camera and light (FrameUniformData in uniformBuffer.h)
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
+
+// (height, dh/dx, dh/dz) per ring vertex, stored toroidally: grid (origin + local) lives at
+// texel (texOffset + local) mod size
+uniform sampler2D heightMap;
+uniform int clipmapSize;
+uniform vec2 levelOrigin;
+uniform ivec2 levelTexOffset;
+uniform float levelSpacing;
+
+vec3 fetchSample(ivec2 local)
+{
+	local = clamp(local, ivec2(0), ivec2(clipmapSize - 1));
+	return texelFetch(heightMap, (levelTexOffset + local) % clipmapSize, 0).rgb;
+}
+
+float fetchHeight(ivec2 local)
+{
+	return fetchSample(local).r;
+}
+
+void main()
+{
+	ivec2 local = ivec2(gl_VertexID % clipmapSize, gl_VertexID / clipmapSize);
+	int last = clipmapSize - 1;
+
+	vec3 texel = fetchSample(local);
+	float height = texel.r;
+
+	// Odd vertices on the outer edge sit mid-edge of the coarser level: follow its straight edge
+	if ((local.x == 0 || local.x == last) && (local.y & 1) == 1)
+		height = 0.5 * (fetchHeight(local - ivec2(0, 1)) + fetchHeight(local + ivec2(0, 1)));
+	if ((local.y == 0 || local.y == last) && (local.x & 1) == 1)
+		height = 0.5 * (fetchHeight(local - ivec2(1, 0)) + fetchHeight(local + ivec2(1, 0)));
+
+	vec2 worldXZ = (levelOrigin + vec2(local)) * levelSpacing;
+	vec3 worldPos = vec3(worldXZ.x, height, worldXZ.y);
+
+	textureCoord = worldXZ / 200.0;
+	fragPos = worldPos;
+	norm = normalize(vec3(-texel.g, 1.0, -texel.b));
+	worldPosXZ = worldXZ;
+
+	gl_Position = viewProjection * vec4(worldPos, 1.0f);
+}
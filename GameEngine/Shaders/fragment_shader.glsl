@@ -8,14 +8,23 @@ in vec2 worldPosXZ;
 out vec4 fragColor;
 
 uniform sampler2D texture1;
-uniform vec3 lightColor;
-uniform vec3 lightPos;
-uniform vec3 viewPos;
 uniform vec3 objectTint;
 
-uniform int numHazards;
-uniform vec3 hazardPositions[10];
-uniform vec3 hazardSizes[10];
+// Hazard zones darkening the ground, looked up through their tile grid (HazardTextures)
+uniform samplerBuffer hazardZones;          // (center x, center z, radius, unused) per zone
+uniform isampler2D hazardTiles;             // (first, count) of each tile's run in hazardTileZones
+uniform isamplerBuffer hazardTileZones;     // zone ids of every tile, ascending
+uniform sampler2D hazardMask;               // darkness baked over the terrain, 0 outside the zones
+
+// Where the tile grid and the mask sit, rewritten only when the zones change (SceneUniformData)
+layout (std140) uniform SceneUniforms
+{
+    vec4 hazardGrid;            // (origin x, origin z, 1 / tile size, unused)
+    ivec4 hazardGridSize;       // (tiles x, tiles z, unused, unused)
+    vec4 hazardMaskArea;        // (min x, min z, 1 / width, 1 when there is a mask)
+};
+
+const vec3 hazardTint = vec3(0.25, 0.15, 0.1);
 
 void main()
 {
@@ -23,21 +32,39 @@ void main()
     
     vec3 finalColor = texColor.rgb * objectTint;
     
-    bool inHazard = false;
-    for (int i = 0; i < numHazards; i++) {
-        vec2 hazardCenter = hazardPositions[i].xz;
-        float hazardRadius = hazardSizes[i].x / 2.0;
-        
-        float dist = distance(worldPosXZ, hazardCenter);
-        
-        if (dist < hazardRadius) {
-            inHazard = true;
-            
-            float normalizedDist = dist / hazardRadius;
-            float darkness = 1.0 - normalizedDist * 0.5;
+    // Over the terrain the darkness is baked: one filtered fetch. Along a zone's rim the
+    // filter blends towards 0, which fades the tint out instead of cutting it off.
+    vec2 maskCoord = (worldPosXZ - hazardMaskArea.xy) * hazardMaskArea.z;
+    if (hazardMaskArea.w > 0.0 &&
+        all(greaterThanEqual(maskCoord, vec2(0.0))) && all(lessThanEqual(maskCoord, vec2(1.0)))) {
+        float darkness = texture(hazardMask, maskCoord).r;
+        finalColor *= mix(vec3(1.0), darkness * hazardTint, min(darkness * 2.0, 1.0));
+    }
+    // Elsewhere only the zones listed for this tile can contain the point, the first one
+    // wins (same tile lookup as HazardIndex::find). Points a tile or more off the grid
+    // are outside every zone.
+    else {
+        vec2 cell = floor((worldPosXZ - hazardGrid.xy) * hazardGrid.z);
+        if (hazardGridSize.x > 0 &&
+            all(greaterThanEqual(cell, vec2(-1.0))) && all(lessThanEqual(cell, vec2(hazardGridSize.xy)))) {
+            ivec2 tile = clamp(ivec2(cell), ivec2(0), hazardGridSize.xy - 1);
+            ivec2 run = texelFetch(hazardTiles, tile, 0).xy;
             
-            finalColor *= darkness * vec3(0.25, 0.15, 0.1);
-            break;
+            for (int i = run.x; i < run.x + run.y; i++) {
+                vec4 hazard = texelFetch(hazardZones, texelFetch(hazardTileZones, i).x);
+                vec2 hazardCenter = hazard.xy;
+                float hazardRadius = hazard.z;
+                
+                float dist = distance(worldPosXZ, hazardCenter);
+                
+                if (dist < hazardRadius) {
+                    float normalizedDist = dist / hazardRadius;
+                    float darkness = 1.0 - normalizedDist * 0.5;
+                    
+                    finalColor *= darkness * hazardTint;
+                    break;
+                }
+            }
         }
     }
     
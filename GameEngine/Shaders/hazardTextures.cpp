@@ -0,0 +1,107 @@
+#include "hazardTextures.h"
+#include "uniformBuffer.h"
+#include <algorithm>
+
+HazardTextures::HazardTextures()
+{
+	glGenBuffers(1, &zoneBuffer);
+	glGenBuffers(1, &tileZoneBuffer);
+	glGenTextures(1, &zoneTexture);
+	glGenTextures(1, &tileZoneTexture);
+	glGenTextures(1, &tileTexture);
+	glGenTextures(1, &maskTexture);
+
+	glBindTexture(GL_TEXTURE_2D, tileTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glActiveTexture(GL_TEXTURE0 + HAZARD_MASK_UNIT);
+	glBindTexture(GL_TEXTURE_2D, maskTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// empty until the first update: no tiles, so no zone is ever looked up
+	update(std::vector<HazardZone>(), HazardIndex());
+}
+
+HazardTextures::~HazardTextures()
+{
+	glDeleteTextures(1, &zoneTexture);
+	glDeleteTextures(1, &tileZoneTexture);
+	glDeleteTextures(1, &tileTexture);
+	glDeleteTextures(1, &maskTexture);
+	glDeleteBuffers(1, &zoneBuffer);
+	glDeleteBuffers(1, &tileZoneBuffer);
+}
+
+// Fills a buffer texture; buffers are never left empty, which some drivers reject
+template <typename T>
+static void uploadBufferTexture(GLuint buffer, GLuint texture, GLenum format, GLint unit, std::vector<T>& data)
+{
+	if (data.empty())
+		data.push_back(T());
+
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	glBufferData(GL_TEXTURE_BUFFER, data.size() * sizeof(T), &data[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+}
+
+void HazardTextures::update(const std::vector<HazardZone>& zones, const HazardIndex& index)
+{
+	std::vector<glm::vec4> discs(zones.size());
+	for (size_t i = 0; i < zones.size(); i++)
+		discs[i] = glm::vec4(zones[i].position.x, zones[i].position.z, zones[i].size.x * 0.5f, 0.0f);
+
+	std::vector<int> tileZones(index.getCellZones());
+
+	// (first, count) per cell from the grid's offsets; one empty tile stands in for no grid
+	int tilesX = std::max(index.getCellsX(), 1);
+	int tilesZ = std::max(index.getCellsZ(), 1);
+	std::vector<glm::ivec2> tiles(static_cast<size_t>(tilesX) * tilesZ, glm::ivec2(0));
+	const std::vector<int>& cellStart = index.getCellStart();
+	for (size_t cell = 0; cell + 1 < cellStart.size(); cell++)
+		tiles[cell] = glm::ivec2(cellStart[cell], cellStart[cell + 1] - cellStart[cell]);
+
+	uploadBufferTexture(zoneBuffer, zoneTexture, GL_RGBA32F, HAZARD_ZONES_UNIT, discs);
+	uploadBufferTexture(tileZoneBuffer, tileZoneTexture, GL_R32I, HAZARD_TILE_ZONES_UNIT, tileZones);
+
+	glActiveTexture(GL_TEXTURE0 + HAZARD_TILES_UNIT);
+	glBindTexture(GL_TEXTURE_2D, tileTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32I, tilesX, tilesZ, 0, GL_RG_INTEGER, GL_INT, &tiles[0]);
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void HazardTextures::setMask(const HazardMask& mask)
+{
+	glActiveTexture(GL_TEXTURE0 + HAZARD_MASK_UNIT);
+	glBindTexture(GL_TEXTURE_2D, maskTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, mask.resolution, mask.resolution, 0, GL_RED, GL_UNSIGNED_BYTE, &mask.texels[0]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void HazardTextures::updateMaskRegion(const HazardMask& mask, const TerrainRegion& region)
+{
+	if (region.isEmpty())
+		return;
+
+	glActiveTexture(GL_TEXTURE0 + HAZARD_MASK_UNIT);
+	glBindTexture(GL_TEXTURE_2D, maskTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, mask.resolution);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, region.x0, region.z0, region.getWidth(), region.getHeight(),
+		GL_RED, GL_UNSIGNED_BYTE, &mask.texels[static_cast<size_t>(region.z0) * mask.resolution + region.x0]);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glew.h>
+#include <vector>
+#include "..\Physics\hazardIndex.h"
+#include "..\Terrain\hazardMask.h"
+
+// GPU copy of the hazard zones and their HazardIndex grid, so the fragment shader can
+// find the zone under a pixel the way HazardIndex::find does: it tests only the zones
+// listed for the pixel's tile instead of every zone, at the same cost for ten zones
+// or thousands.
+//
+// - hazardZones (texture buffer, RGBA32F): (center x, center z, radius, unused) per zone
+// - hazardTiles (2D, RG32I, one texel per grid cell): first entry and count of the
+//   cell's run in hazardTileZones
+// - hazardTileZones (texture buffer, R32I): zone ids of every cell, ascending
+// - hazardMask (2D, R8, filtered): the HazardMask baked over the terrain, which the
+//   shader samples instead of searching wherever it covers
+//
+// The textures stay bound to their units in uniformBuffer.h; where the grid and the
+// mask sit in the world goes to the shaders through SceneUniforms.
+class HazardTextures
+{
+public:
+	HazardTextures();
+	~HazardTextures();
+
+	// Re-uploads all three textures; call when the zones change, not every frame
+	void update(const std::vector<HazardZone>& zones, const HazardIndex& index);
+
+	// Uploads the whole mask, then only the texels of region after it was re-baked
+	void setMask(const HazardMask& mask);
+	void updateMaskRegion(const HazardMask& mask, const TerrainRegion& region);
+
+private:
+	HazardTextures(const HazardTextures&);
+	HazardTextures& operator=(const HazardTextures&);
+
+	GLuint zoneBuffer;
+	GLuint zoneTexture;
+	GLuint tileZoneBuffer;
+	GLuint tileZoneTexture;
+	GLuint tileTexture;
+	GLuint maskTexture;
+};
@@ -1,4 +1,5 @@
 #include "shader.h"
+#include "uniformBuffer.h"
 #include <iostream>
 #include <vector>
 
@@ -97,6 +98,101 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
  
 	glDeleteShader(vertex);
 	glDeleteShader(fragment);
+
+	loadUniforms();
+	bindUniformBlocks();
+	bindSamplerUnits();
+}
+
+void Shader::loadUniforms()
+{
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	std::vector<char> buffer(maxLength + 1);
+	for (GLint i = 0; i < count; i++)
+	{
+		GLint size = 0;
+		GLenum type = 0;
+		GLsizei length = 0;
+		glGetActiveUniform(id, i, static_cast<GLsizei>(buffer.size()), &length, &size, &type, &buffer[0]);
+
+		// arrays are reported as "name[0]"
+		std::string name(&buffer[0], length);
+		size_t bracket = name.find('[');
+		if (bracket != std::string::npos)
+			name.erase(bracket);
+
+		GLint location = glGetUniformLocation(id, name.c_str());
+		if (location < 0)
+			continue;	// uniform block members have no location
+
+		uniforms[name] = location;
+		for (GLint element = 0; element < size && size > 1; element++)
+		{
+			std::string elementName = name + "[" + std::to_string(element) + "]";
+			uniforms[elementName] = glGetUniformLocation(id, elementName.c_str());
+		}
+		if (size == 1 && bracket != std::string::npos)
+			uniforms[name + "[0]"] = location;
+	}
+}
+
+// shared blocks the program declares are attached to their fixed binding points
+void Shader::bindUniformBlocks()
+{
+	for (const UniformBlockBinding& block : UNIFORM_BLOCK_BINDINGS)
+	{
+		GLuint index = glGetUniformBlockIndex(id, block.name);
+		if (index != GL_INVALID_INDEX)
+			glUniformBlockBinding(id, index, block.binding);
+	}
+}
+
+// shared samplers the program declares are set to their fixed texture units
+void Shader::bindSamplerUnits()
+{
+	glUseProgram(id);
+	for (const SamplerUnitBinding& sampler : SAMPLER_UNIT_BINDINGS)
+		setInt(getUniform(sampler.name), sampler.unit);
+	glUseProgram(0);
+}
+
+GLint Shader::getUniform(const std::string& name) const
+{
+	auto it = uniforms.find(name);
+	return it != uniforms.end() ? it->second : -1;
+}
+
+void Shader::setInt(GLint location, int value)
+{
+	glUniform1i(location, value);
+}
+
+void Shader::setFloat(GLint location, float value)
+{
+	glUniform1f(location, value);
+}
+
+void Shader::setVec2(GLint location, const glm::vec2& value)
+{
+	glUniform2f(location, value.x, value.y);
+}
+
+void Shader::setIVec2(GLint location, const glm::ivec2& value)
+{
+	glUniform2i(location, value.x, value.y);
+}
+
+void Shader::setVec3(GLint location, const glm::vec3& value)
+{
+	glUniform3f(location, value.x, value.y, value.z);
+}
+
+void Shader::setMat4(GLint location, const glm::mat4& value)
+{
+	glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
 }
 
 void Shader::use()
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <glew.h>
+#include <glm.hpp>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
 
 class Shader
 {
@@ -14,7 +16,30 @@ public:
 	void use();
 	int getId();
 
+	// Uniform blocks named in UNIFORM_BLOCK_BINDINGS (uniformBuffer.h) are bound to their
+	// binding points at link time; their members are set through UniformBuffer, not here.
+	// Samplers named in SAMPLER_UNIT_BINDINGS are likewise pointed at their texture units.
+
+	// Location of an active uniform, read from the program once when it is linked.
+	// Arrays answer to "name", "name[0]" and every "name[i]". Returns -1 for names the
+	// program does not use, which the setters ignore, like glUniform* does.
+	// Look handles up once and keep them: this is a hash lookup, not a free call.
+	GLint getUniform(const std::string& name) const;
+
+	// Typed setters for the program in use, taking handles from getUniform
+	void setInt(GLint location, int value);
+	void setFloat(GLint location, float value);
+	void setVec2(GLint location, const glm::vec2& value);
+	void setIVec2(GLint location, const glm::ivec2& value);
+	void setVec3(GLint location, const glm::vec3& value);
+	void setMat4(GLint location, const glm::mat4& value);
+
 private:
+	void loadUniforms();
+	void bindUniformBlocks();
+	void bindSamplerUnits();
+
 	unsigned int id;
+	std::unordered_map<std::string, GLint> uniforms;
 };
 
@@ -2,10 +2,19 @@
 
 layout (location = 0) in vec3 pos;
 
+// Per-frame camera and light (FrameUniformData in uniformBuffer.h)
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightColor;
+};
 
-uniform mat4 MVP;
-
+// The sun is drawn at the light's position
 void main()
 {
-    gl_Position = MVP * vec4(pos, 1.0f);
+    gl_Position = viewProjection * vec4(pos + lightPosition.xyz, 1.0f);
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#version 400
+
+// No vertex attributes: gl_VertexID is the patch vertex index, row-major over
+// (patchResolution + 1)^2 vertices
+
+out vec2 textureCoord;
+out vec3 norm;
+out vec3 fragPos;
+out vec2 worldPosXZ;
+
+// Per-frame camera and light (FrameUniformData in uniformBuffer.h)
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
+
+// one texel per terrain grid vertex: 16-bit quantized height and octahedral normal
+uniform sampler2D heightMap;
+uniform sampler2D normalMap;
+uniform vec2 heightRange;		// (min height, max - min)
+uniform float heightMapSize;
+uniform float worldSize;
+
+// current quadtree node
+uniform vec2 nodeOrigin;
+uniform float nodeSize;
+uniform float patchResolution;
+uniform vec2 morphRange;
+uniform vec3 lodCameraPos;
+
+vec2 gridTexelUV(vec2 worldXZ, out vec2 gridUV)
+{
+	gridUV = (worldXZ + worldSize) / (2.0 * worldSize);
+	return (gridUV * (heightMapSize - 1.0) + 0.5) / heightMapSize;
+}
+
+float sampleHeight(vec2 texelUV)
+{
+	return heightRange.x + heightRange.y * textureLod(heightMap, texelUV, 0.0).r;
+}
+
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+	if (n.y < 0.0)
+		n.xz = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
+void main()
+{
+	int verticesPerSide = int(patchResolution) + 1;
+	vec2 patchPos = vec2(gl_VertexID % verticesPerSide, gl_VertexID / verticesPerSide) / patchResolution;
+
+	vec2 gridUV;
+	vec2 worldXZ = nodeOrigin + patchPos * nodeSize;
+	float height = sampleHeight(gridTexelUV(worldXZ, gridUV));
+
+	// Slide odd vertices onto the next coarser grid as the node nears its range limit
+	float dist = distance(lodCameraPos, vec3(worldXZ.x, height, worldXZ.y));
+	float morph = clamp((dist - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+	vec2 oddOffset = fract(patchPos * patchResolution * 0.5) * 2.0 / patchResolution;
+	patchPos -= oddOffset * morph;
+
+	worldXZ = nodeOrigin + patchPos * nodeSize;
+	vec2 texelUV = gridTexelUV(worldXZ, gridUV);
+
+	vec3 worldPos = vec3(worldXZ.x, sampleHeight(texelUV), worldXZ.y);
+
+	textureCoord = gridUV * 10.0;
+	fragPos = worldPos;
+	norm = decodeOctahedral(textureLod(normalMap, texelUV, 0.0).rg);
+	worldPosXZ = worldXZ;
+
+	gl_Position = viewProjection * vec4(worldPos, 1.0f);
+}
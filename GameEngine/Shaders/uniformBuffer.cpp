@@ -0,0 +1,33 @@
+#include "uniformBuffer.h"
+#include <cstring>
+
+UniformBuffer::UniformBuffer(GLuint binding, size_t size)
+	: lastData(size)
+	, written(false)
+{
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	glDeleteBuffers(1, &buffer);
+}
+
+bool UniformBuffer::update(const void* data)
+{
+	if (written && std::memcmp(lastData.data(), data, lastData.size()) == 0)
+		return false;
+
+	std::memcpy(lastData.data(), data, lastData.size());
+	written = true;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, lastData.size(), data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <glew.h>
+#include <glm.hpp>
+#include <vector>
+
+// Uniform blocks shared by every program. Shader binds each block it declares to the
+// binding point listed here when it is linked, so one buffer per block serves them all.
+struct UniformBlockBinding
+{
+	const char* name;
+	GLuint binding;
+};
+
+const GLuint FRAME_UNIFORMS_BINDING = 0;
+const GLuint SCENE_UNIFORMS_BINDING = 1;
+
+const UniformBlockBinding UNIFORM_BLOCK_BINDINGS[] = {
+	{ "FrameUniforms", FRAME_UNIFORMS_BINDING },
+	{ "SceneUniforms", SCENE_UNIFORMS_BINDING },
+};
+
+// Samplers shared the same way: Shader points each one it declares at its fixed texture
+// unit at link time. Units from 8 up are clear of the ones meshes and terrain bind.
+struct SamplerUnitBinding
+{
+	const char* name;
+	GLint unit;
+};
+
+const GLint HAZARD_ZONES_UNIT = 8;
+const GLint HAZARD_TILES_UNIT = 9;
+const GLint HAZARD_TILE_ZONES_UNIT = 10;
+const GLint HAZARD_MASK_UNIT = 11;
+
+const SamplerUnitBinding SAMPLER_UNIT_BINDINGS[] = {
+	{ "hazardZones", HAZARD_ZONES_UNIT },
+	{ "hazardTiles", HAZARD_TILES_UNIT },
+	{ "hazardTileZones", HAZARD_TILE_ZONES_UNIT },
+	{ "hazardMask", HAZARD_MASK_UNIT },
+};
+
+// std140 layouts of the blocks, declared the same way in the shaders that use them
+
+struct FrameUniformData
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::vec4 cameraPosition;	// w unused
+	glm::vec4 lightPosition;	// w unused
+	glm::vec4 lightColor;		// w unused
+};
+
+// Placement of the hazard tile grid and of the baked hazard mask (HazardTextures) in XZ
+struct SceneUniformData
+{
+	glm::vec4 hazardGrid;		// (origin x, origin z, 1 / tile size, unused)
+	glm::ivec4 hazardGridSize;	// (tiles x, tiles z, unused, unused), 0 tiles when there are no zones
+	glm::vec4 hazardMaskArea;	// (min x, min z, 1 / width, 1 when there is a mask else 0)
+};
+
+static_assert(sizeof(FrameUniformData) == 240, "FrameUniformData must match the std140 FrameUniforms block");
+static_assert(sizeof(SceneUniformData) == 48, "SceneUniformData must match the std140 SceneUniforms block");
+
+// Buffer behind one uniform block, bound to its binding point for its whole life.
+// update() writes the block with a single glBufferSubData, and not at all when the
+// data equals what was written last.
+class UniformBuffer
+{
+public:
+	UniformBuffer(GLuint binding, size_t size);
+	~UniformBuffer();
+
+	// Returns whether the buffer was written
+	bool update(const void* data);
+
+private:
+	UniformBuffer(const UniformBuffer&);
+	UniformBuffer& operator=(const UniformBuffer&);
+
+	GLuint buffer;
+	std::vector<char> lastData;
+	bool written;
+};
@@ -3,22 +3,31 @@
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec3 normals;
 layout (location = 2) in vec2 texCoord;
+layout (location = 3) in mat4 instanceModel;	// per instance, see Mesh::drawInstanced
 
 out vec2 textureCoord;
 out vec3 norm;
 out vec3 fragPos;
 out vec2 worldPosXZ;
 
-uniform mat4 MVP;
-uniform mat4 model;
+// Per-frame camera and light (FrameUniformData in uniformBuffer.h)
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 cameraPosition;
+	vec4 lightPosition;
+	vec4 lightColor;
+};
 
 void main()
 {
 	textureCoord = texCoord;
-	fragPos = vec3(model * vec4(pos, 1.0f));
-	norm = mat3(transpose(inverse(model)))*normals;
+	fragPos = vec3(instanceModel * vec4(pos, 1.0f));
+	norm = mat3(transpose(inverse(instanceModel)))*normals;
 	
 	worldPosXZ = fragPos.xz;
 	
-	gl_Position = MVP * vec4(pos, 1.0f);
+	gl_Position = viewProjection * vec4(fragPos, 1.0f);
 }
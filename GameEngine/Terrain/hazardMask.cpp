@@ -0,0 +1,90 @@
+#include "hazardMask.h"
+#include "..\Utils\threadPool.h"
+#include <algorithm>
+#include <cmath>
+
+// Same banding as the terrain rows
+static const int HAZARD_MASK_ROWS_PER_BAND = 16;
+
+// Only the zones whose bounding square overlaps the band are drawn, each over the texels
+// under it in every row, so the cost follows the zone footprints rather than texels x zones.
+// They are drawn from the last to the first, leaving each texel to the first zone that
+// contains it, the one HazardIndex::find reports.
+static void bakeRows(HazardMask& mask, int x0, int x1, int zBegin, int zEnd, const std::vector<HazardZone>& zones)
+{
+    float texel = mask.getTexelSize();
+
+    std::vector<int> candidates;
+    findPitsInRect(zones, mask.getCoordinate(x0), mask.getCoordinate(zBegin),
+        mask.getCoordinate(x1), mask.getCoordinate(zEnd - 1), candidates);
+
+    for (int z = zBegin; z < zEnd; ++z) {
+        unsigned char* row = &mask.texels[static_cast<size_t>(z) * mask.resolution];
+        std::fill(row + x0, row + x1 + 1, 0);
+        float pointZ = mask.getCoordinate(z);
+
+        for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+            const HazardZone& zone = zones[*it];
+            float radius = zone.size.x * 0.5f;
+            float dz = pointZ - zone.position.z;
+            if (!(std::fabs(dz) < radius))
+                continue;
+
+            // Texels under the disc's chord on this row, padded by one; the exact test decides
+            float halfChord = std::sqrt(radius * radius - dz * dz);
+            int first = std::max(x0, (int)std::floor((zone.position.x - halfChord + mask.size) / texel - 0.5f) - 1);
+            int last = std::min(x1, (int)std::ceil((zone.position.x + halfChord + mask.size) / texel - 0.5f) + 1);
+
+            for (int x = first; x <= last; ++x) {
+                float dx = mask.getCoordinate(x) - zone.position.x;
+                float distanceSquared = dx * dx + dz * dz;
+                if (!(distanceSquared < radius * radius))
+                    continue;
+
+                float darkness = 1.0f - std::sqrt(distanceSquared) / radius * 0.5f;
+                row[x] = static_cast<unsigned char>(darkness * 255.0f + 0.5f);
+            }
+        }
+    }
+}
+
+HazardMask buildHazardMask(float size, int resolution, const std::vector<HazardZone>& zones)
+{
+    HazardMask mask;
+    mask.size = size;
+    mask.resolution = resolution;
+    mask.texels.resize(static_cast<size_t>(resolution) * resolution);
+
+    ThreadPool::shared().parallelFor(0, resolution, HAZARD_MASK_ROWS_PER_BAND, [&](int zBegin, int zEnd) {
+        bakeRows(mask, 0, resolution - 1, zBegin, zEnd, zones);
+    });
+
+    return mask;
+}
+
+TerrainRegion getHazardMaskRegion(const HazardMask& mask, const HazardZone& zone)
+{
+    // Texel i is centred at -size + (i + 0.5) * texel; one texel of slack for rounding
+    float radius = zone.size.x / 2.0f;
+    float texel = mask.getTexelSize();
+    int last = mask.resolution - 1;
+
+    TerrainRegion region;
+    region.x0 = std::max(0, (int)std::floor((zone.position.x - radius + mask.size) / texel - 0.5f) - 1);
+    region.z0 = std::max(0, (int)std::floor((zone.position.z - radius + mask.size) / texel - 0.5f) - 1);
+    region.x1 = std::min(last, (int)std::ceil((zone.position.x + radius + mask.size) / texel - 0.5f) + 1);
+    region.z1 = std::min(last, (int)std::ceil((zone.position.z + radius + mask.size) / texel - 0.5f) + 1);
+    return region;
+}
+
+TerrainRegion rebakeHazardMaskRegion(HazardMask& mask, const TerrainRegion& region, const std::vector<HazardZone>& zones)
+{
+    if (region.isEmpty())
+        return region;
+
+    ThreadPool::shared().parallelFor(region.z0, region.z1 + 1, HAZARD_MASK_ROWS_PER_BAND, [&](int zBegin, int zEnd) {
+        bakeRows(mask, region.x0, region.x1, zBegin, zEnd, zones);
+    });
+
+    return region;
+}
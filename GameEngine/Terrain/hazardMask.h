@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include "terrain.h"
+
+// How dark the pits make the ground, baked into a world-space grid of texels spanning
+// [-size, size] on X and Z (the terrain's extent). The fragment shader samples it once
+// per pixel instead of searching for the zone under the pixel. Texel (x, z) is centred
+// at getCoordinate(x), getCoordinate(z); rows run along +X, row z starts at z * resolution.
+//
+// A texel holds 0 outside every zone and 255 * (1 - 0.5 * distance / radius) inside the
+// first zone containing its centre, the factor the shader tints the ground with.
+struct HazardMask
+{
+    float size;
+    int resolution;
+    std::vector<unsigned char> texels;
+
+    float getTexelSize() const { return 2.0f * size / (float)resolution; }
+    float getCoordinate(int i) const { return -size + ((float)i + 0.5f) * getTexelSize(); }
+};
+
+// Bakes every texel from the zones, in row bands on ThreadPool::shared()
+HazardMask buildHazardMask(float size, int resolution, const std::vector<HazardZone>& zones);
+
+// Texels whose centre a zone can cover (its bounding square), as an inclusive block
+TerrainRegion getHazardMaskRegion(const HazardMask& mask, const HazardZone& zone);
+
+// Re-bakes the texels in region from the current zones, after one was added or removed.
+// Returns the block that was rewritten.
+TerrainRegion rebakeHazardMaskRegion(HazardMask& mask, const TerrainRegion& region, const std::vector<HazardZone>& zones);
@@ -0,0 +1,287 @@
+#include "heightfield.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define HEIGHTFIELD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define HEIGHTFIELD_TARGET_AVX2
+#else
+#define HEIGHTFIELD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+// Octaves of the base height: amplitude * sin(x * frequency) * cos(z * frequency)
+static const float OCTAVE_AMPLITUDE[3] = { 0.5f, 0.3f, 0.2f };
+static const float OCTAVE_FREQUENCY[3] = { 0.05f, 0.15f, 0.3f };
+
+// amplitude * frequency, the octave's factor in both partial derivatives:
+// dh/dx = sum(af * cos(x f) * cos(z f)), dh/dz = -sum(af * sin(x f) * sin(z f))
+static const float OCTAVE_SLOPE[3] = { 0.5f * 0.05f, 0.3f * 0.15f, 0.2f * 0.3f };
+
+// Cephes sinf/cosf constants: 4/pi, pi/4 split in three parts, minimax polynomials on [-pi/4, pi/4]
+static const float FOPI = 1.27323954473516f;
+static const float DP1 = 0.78515625f;
+static const float DP2 = 2.4187564849853515625e-4f;
+static const float DP3 = 3.77489497744594108e-8f;
+static const float SIN_P0 = -1.9515295891e-4f;
+static const float SIN_P1 = 8.3321608736e-3f;
+static const float SIN_P2 = -1.6666654611e-1f;
+static const float COS_P0 = 2.443315711809948e-5f;
+static const float COS_P1 = -1.388731625493765e-3f;
+static const float COS_P2 = 4.166664568298827e-2f;
+
+// ---------- SCALAR ----------
+
+static inline void sincosScalar(float x, float& s, float& c)
+{
+    float ax = std::fabs(x);
+
+    int j = static_cast<int>(ax * FOPI);
+    j = (j + 1) & ~1;
+    float y = static_cast<float>(j);
+
+    bool swap = (j & 2) != 0;
+    bool sinNegative = ((j & 4) != 0) != std::signbit(x);
+    bool cosNegative = (~(j - 2) & 4) != 0;
+
+    float r = ((ax - y * DP1) - y * DP2) - y * DP3;
+    float z = r * r;
+
+    float polyS = ((SIN_P0 * z + SIN_P1) * z + SIN_P2) * z * r + r;
+    float polyC = ((COS_P0 * z + COS_P1) * z + COS_P2) * z * z - 0.5f * z + 1.0f;
+
+    float sv = swap ? polyC : polyS;
+    float cv = swap ? polyS : polyC;
+
+    s = sinNegative ? -sv : sv;
+    c = cosNegative ? -cv : cv;
+}
+
+static inline float heightScalar(float x, float z)
+{
+    float octave[3];
+    for (int i = 0; i < 3; ++i) {
+        float sx, cx, sz, cz;
+        sincosScalar(x * OCTAVE_FREQUENCY[i], sx, cx);
+        sincosScalar(z * OCTAVE_FREQUENCY[i], sz, cz);
+        octave[i] = OCTAVE_AMPLITUDE[i] * sx * cz;
+    }
+    return (octave[0] + octave[1]) + octave[2];
+}
+
+static inline void heightSlopeScalar(float x, float z, float& height, float& slopeX, float& slopeZ)
+{
+    float octave[3], octaveX[3], octaveZ[3];
+    for (int i = 0; i < 3; ++i) {
+        float sx, cx, sz, cz;
+        sincosScalar(x * OCTAVE_FREQUENCY[i], sx, cx);
+        sincosScalar(z * OCTAVE_FREQUENCY[i], sz, cz);
+        octave[i] = OCTAVE_AMPLITUDE[i] * sx * cz;
+        octaveX[i] = OCTAVE_SLOPE[i] * cx * cz;
+        octaveZ[i] = OCTAVE_SLOPE[i] * sx * sz;
+    }
+    height = (octave[0] + octave[1]) + octave[2];
+    slopeX = (octaveX[0] + octaveX[1]) + octaveX[2];
+    slopeZ = -((octaveZ[0] + octaveZ[1]) + octaveZ[2]);
+}
+
+// slopesX / slopesZ may be null when only heights are wanted
+static void evaluateScalar(const float* xs, const float* zs, float* heights, float* slopesX, float* slopesZ, int count)
+{
+    if (!slopesX) {
+        for (int i = 0; i < count; ++i)
+            heights[i] = heightScalar(xs[i], zs[i]);
+        return;
+    }
+
+    for (int i = 0; i < count; ++i)
+        heightSlopeScalar(xs[i], zs[i], heights[i], slopesX[i], slopesZ[i]);
+}
+
+#ifdef HEIGHTFIELD_X86
+
+// ---------- SSE2 (4 lanes) ----------
+
+static inline void sincosSSE2(__m128 x, __m128& s, __m128& c)
+{
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u)));
+
+    __m128 signX = _mm_and_ps(x, signMask);
+    __m128 ax = _mm_andnot_ps(signMask, x);
+
+    __m128i j = _mm_cvttps_epi32(_mm_mul_ps(ax, _mm_set1_ps(FOPI)));
+    j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+    __m128 y = _mm_cvtepi32_ps(j);
+
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+    __m128 sinSign = _mm_xor_ps(signX, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29)));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+        _mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+
+    __m128 r = _mm_sub_ps(ax, _mm_mul_ps(y, _mm_set1_ps(DP1)));
+    r = _mm_sub_ps(r, _mm_mul_ps(y, _mm_set1_ps(DP2)));
+    r = _mm_sub_ps(r, _mm_mul_ps(y, _mm_set1_ps(DP3)));
+    __m128 z = _mm_mul_ps(r, r);
+
+    __m128 polyS = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_P0), z), _mm_set1_ps(SIN_P1));
+    polyS = _mm_add_ps(_mm_mul_ps(polyS, z), _mm_set1_ps(SIN_P2));
+    polyS = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(polyS, z), r), r);
+
+    __m128 polyC = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_P0), z), _mm_set1_ps(COS_P1));
+    polyC = _mm_add_ps(_mm_mul_ps(polyC, z), _mm_set1_ps(COS_P2));
+    polyC = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(polyC, z), z), _mm_mul_ps(_mm_set1_ps(0.5f), z));
+    polyC = _mm_add_ps(polyC, _mm_set1_ps(1.0f));
+
+    __m128 sv = _mm_or_ps(_mm_and_ps(swap, polyC), _mm_andnot_ps(swap, polyS));
+    __m128 cv = _mm_or_ps(_mm_and_ps(swap, polyS), _mm_andnot_ps(swap, polyC));
+
+    s = _mm_xor_ps(sv, sinSign);
+    c = _mm_xor_ps(cv, cosSign);
+}
+
+static void evaluateSSE2(const float* xs, const float* zs, float* heights, float* slopesX, float* slopesZ, int count)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(xs + i);
+        __m128 z = _mm_loadu_ps(zs + i);
+
+        __m128 octave[3], octaveX[3], octaveZ[3];
+        for (int o = 0; o < 3; ++o) {
+            __m128 frequency = _mm_set1_ps(OCTAVE_FREQUENCY[o]);
+            __m128 sx, cx, sz, cz;
+            sincosSSE2(_mm_mul_ps(x, frequency), sx, cx);
+            sincosSSE2(_mm_mul_ps(z, frequency), sz, cz);
+            octave[o] = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(OCTAVE_AMPLITUDE[o]), sx), cz);
+            octaveX[o] = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(OCTAVE_SLOPE[o]), cx), cz);
+            octaveZ[o] = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(OCTAVE_SLOPE[o]), sx), sz);
+        }
+
+        _mm_storeu_ps(heights + i, _mm_add_ps(_mm_add_ps(octave[0], octave[1]), octave[2]));
+
+        if (slopesX) {
+            __m128 slopeZ = _mm_add_ps(_mm_add_ps(octaveZ[0], octaveZ[1]), octaveZ[2]);
+            _mm_storeu_ps(slopesX + i, _mm_add_ps(_mm_add_ps(octaveX[0], octaveX[1]), octaveX[2]));
+            _mm_storeu_ps(slopesZ + i, _mm_xor_ps(slopeZ, _mm_set1_ps(-0.0f)));
+        }
+    }
+
+    evaluateScalar(xs + i, zs + i, heights + i, slopesX ? slopesX + i : nullptr, slopesZ ? slopesZ + i : nullptr, count - i);
+}
+
+// ---------- AVX2 (8 lanes) ----------
+
+HEIGHTFIELD_TARGET_AVX2
+static inline void sincosAVX2(__m256 x, __m256& s, __m256& c)
+{
+    const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(0x80000000u)));
+
+    __m256 signX = _mm256_and_ps(x, signMask);
+    __m256 ax = _mm256_andnot_ps(signMask, x);
+
+    __m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(ax, _mm256_set1_ps(FOPI)));
+    j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+    __m256 y = _mm256_cvtepi32_ps(j);
+
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(2)));
+    __m256 sinSign = _mm256_xor_ps(signX, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29)));
+    __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+
+    __m256 r = _mm256_sub_ps(ax, _mm256_mul_ps(y, _mm256_set1_ps(DP1)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(y, _mm256_set1_ps(DP2)));
+    r = _mm256_sub_ps(r, _mm256_mul_ps(y, _mm256_set1_ps(DP3)));
+    __m256 z = _mm256_mul_ps(r, r);
+
+    __m256 polyS = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIN_P0), z), _mm256_set1_ps(SIN_P1));
+    polyS = _mm256_add_ps(_mm256_mul_ps(polyS, z), _mm256_set1_ps(SIN_P2));
+    polyS = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(polyS, z), r), r);
+
+    __m256 polyC = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COS_P0), z), _mm256_set1_ps(COS_P1));
+    polyC = _mm256_add_ps(_mm256_mul_ps(polyC, z), _mm256_set1_ps(COS_P2));
+    polyC = _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(polyC, z), z), _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+    polyC = _mm256_add_ps(polyC, _mm256_set1_ps(1.0f));
+
+    __m256 sv = _mm256_blendv_ps(polyS, polyC, swap);
+    __m256 cv = _mm256_blendv_ps(polyC, polyS, swap);
+
+    s = _mm256_xor_ps(sv, sinSign);
+    c = _mm256_xor_ps(cv, cosSign);
+}
+
+HEIGHTFIELD_TARGET_AVX2
+static void evaluateAVX2(const float* xs, const float* zs, float* heights, float* slopesX, float* slopesZ, int count)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(xs + i);
+        __m256 z = _mm256_loadu_ps(zs + i);
+
+        __m256 octave[3], octaveX[3], octaveZ[3];
+        for (int o = 0; o < 3; ++o) {
+            __m256 frequency = _mm256_set1_ps(OCTAVE_FREQUENCY[o]);
+            __m256 sx, cx, sz, cz;
+            sincosAVX2(_mm256_mul_ps(x, frequency), sx, cx);
+            sincosAVX2(_mm256_mul_ps(z, frequency), sz, cz);
+            octave[o] = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(OCTAVE_AMPLITUDE[o]), sx), cz);
+            octaveX[o] = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(OCTAVE_SLOPE[o]), cx), cz);
+            octaveZ[o] = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(OCTAVE_SLOPE[o]), sx), sz);
+        }
+
+        _mm256_storeu_ps(heights + i, _mm256_add_ps(_mm256_add_ps(octave[0], octave[1]), octave[2]));
+
+        if (slopesX) {
+            __m256 slopeZ = _mm256_add_ps(_mm256_add_ps(octaveZ[0], octaveZ[1]), octaveZ[2]);
+            _mm256_storeu_ps(slopesX + i, _mm256_add_ps(_mm256_add_ps(octaveX[0], octaveX[1]), octaveX[2]));
+            _mm256_storeu_ps(slopesZ + i, _mm256_xor_ps(slopeZ, _mm256_set1_ps(-0.0f)));
+        }
+    }
+
+    evaluateSSE2(xs + i, zs + i, heights + i, slopesX ? slopesX + i : nullptr, slopesZ ? slopesZ + i : nullptr, count - i);
+}
+
+#endif // HEIGHTFIELD_X86
+
+// ---------- DISPATCH ----------
+
+static void evaluate(const float* xs, const float* zs, float* heights, float* slopesX, float* slopesZ, int count, SimdPath path)
+{
+#ifdef HEIGHTFIELD_X86
+    if (path == SimdPath::AVX2 && getSimdPath() == SimdPath::AVX2) {
+        evaluateAVX2(xs, zs, heights, slopesX, slopesZ, count);
+        return;
+    }
+    if (path != SimdPath::Scalar) {
+        evaluateSSE2(xs, zs, heights, slopesX, slopesZ, count);
+        return;
+    }
+#endif
+    evaluateScalar(xs, zs, heights, slopesX, slopesZ, count);
+}
+
+void evaluateTerrainHeights(const float* xs, const float* zs, float* heights, int count)
+{
+    evaluate(xs, zs, heights, nullptr, nullptr, count, getSimdPath());
+}
+
+void evaluateTerrainHeights(const float* xs, const float* zs, float* heights, int count, SimdPath path)
+{
+    evaluate(xs, zs, heights, nullptr, nullptr, count, path);
+}
+
+void evaluateTerrainHeightsAndSlopes(const float* xs, const float* zs, float* heights, float* slopesX, float* slopesZ, int count)
+{
+    evaluate(xs, zs, heights, slopesX, slopesZ, count, getSimdPath());
+}
+
+void evaluateTerrainHeightsAndSlopes(const float* xs, const float* zs, float* heights, float* slopesX, float* slopesZ, int count,
+    SimdPath path)
+{
+    evaluate(xs, zs, heights, slopesX, slopesZ, count, path);
+}
+
+float sampleTerrainBaseHeight(float x, float z)
+{
+    return heightScalar(x, z);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "..\Utils\cpuFeatures.h"
+
+// Procedural base height of the alien desert (three sin*cos octaves, pits not included).
+//
+// All evaluation goes through one batch kernel with AVX2 (8 lanes), SSE2 (4 lanes) and
+// scalar implementations, picked at runtime. There is no 16-lane AVX-512 path; CPUs that
+// have it take the AVX2 one. sin/cos use a Cephes-style polynomial with three-constant
+// range reduction instead of the CRT: for |arg| <= 8192 the absolute error of each sin/cos
+// is below 2.5e-7. An octave a * sin * cos is then off by at most a * 2 * 2.5e-7, so with
+// the octave amplitudes summing to 1 the height error is at most 2 x 2.5e-7 = 5e-7.
+// World coordinates up to +/-27000 stay inside that range.
+// Every path runs the same float operations in the same order, so a point gets the same
+// height bit for bit whichever path or batch size evaluates it.
+
+// heights[i] = base height at (xs[i], zs[i]) for i in [0, count)
+void evaluateTerrainHeights(const float* xs, const float* zs, float* heights, int count);
+void evaluateTerrainHeights(const float* xs, const float* zs, float* heights, int count, SimdPath path);
+
+// Same heights plus the analytic partial derivatives slopesX[i] = dh/dx and slopesZ[i] = dh/dz,
+// from the sin/cos the height already needs; the surface normal is normalize(-dh/dx, 1, -dh/dz)
+void evaluateTerrainHeightsAndSlopes(const float* xs, const float* zs, float* heights, float* slopesX, float* slopesZ, int count);
+void evaluateTerrainHeightsAndSlopes(const float* xs, const float* zs, float* heights, float* slopesX, float* slopesZ, int count,
+    SimdPath path);
+
+// Single point query for gameplay code, same result as the batch kernel
+float sampleTerrainBaseHeight(float x, float z);
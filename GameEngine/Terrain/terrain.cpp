@@ -0,0 +1,164 @@
+#include "terrain.h"
+#include "..\Utils\threadPool.h"
+#include <algorithm>
+#include <cmath>
+
+// Rows handed to a worker at a time; small enough to balance, large enough to amortize
+static const int TERRAIN_ROWS_PER_BAND = 16;
+
+float carvePits(float x, float z, float height, const std::vector<HazardZone>& pits)
+{
+    for (const auto& pit : pits) {
+        float dx = x - pit.position.x;
+        float dz = z - pit.position.z;
+        float distance = sqrt(dx * dx + dz * dz);
+        float pitRadius = pit.size.x / 2.0f;
+
+        if (distance < pitRadius) {
+            float normalizedDist = distance / pitRadius;
+            float falloff = 1.0f - normalizedDist;
+            falloff = falloff * falloff;
+            float pitDepth = 4.0f;
+            height -= pitDepth * falloff;
+        }
+    }
+    return height;
+}
+
+void findPitsInRect(const std::vector<HazardZone>& pits, float minX, float minZ, float maxX, float maxZ,
+    std::vector<int>& candidates)
+{
+    for (int i = 0; i < (int)pits.size(); ++i) {
+        const HazardZone& pit = pits[i];
+        float pitRadius = pit.size.x / 2.0f;
+        if (!(pitRadius > 0.0f))
+            continue;
+
+        // Slightly padded so float rounding never rejects a pit the exact test would keep
+        float reach = pitRadius * 1.0001f;
+        if (pit.position.x + reach >= minX && pit.position.x - reach <= maxX &&
+            pit.position.z + reach >= minZ && pit.position.z - reach <= maxZ)
+            candidates.push_back(i);
+    }
+}
+
+void carvePitsRow(const float* xs, int count, float spacing, float z, float* heights, float* slopesX, float* slopesZ,
+    const std::vector<HazardZone>& pits, const std::vector<int>& candidates)
+{
+    if (count <= 0)
+        return;
+
+    for (int index : candidates) {
+        const HazardZone& pit = pits[index];
+        float pitRadius = pit.size.x / 2.0f;
+
+        float dz = z - pit.position.z;
+        if (!(std::fabs(dz) < pitRadius * 1.0001f))
+            continue;
+
+        // Column range under the bounding square, padded by one sample so rounding in xs
+        // can never drop a covered vertex; the exact distance test below decides
+        int first = (int)std::floor((pit.position.x - pitRadius - xs[0]) / spacing) - 1;
+        int last = (int)std::ceil((pit.position.x + pitRadius - xs[0]) / spacing) + 1;
+        first = std::max(first, 0);
+        last = std::min(last, count - 1);
+
+        for (int i = first; i <= last; ++i) {
+            float dx = xs[i] - pit.position.x;
+            float distance = sqrt(dx * dx + dz * dz);
+
+            if (distance < pitRadius) {
+                float normalizedDist = distance / pitRadius;
+                float falloff = 1.0f - normalizedDist;
+                float edge = falloff;
+                falloff = falloff * falloff;
+                float pitDepth = 4.0f;
+                heights[i] -= pitDepth * falloff;
+
+                // d/dx of -depth * (1 - d / r)^2 is 2 * depth * (1 - d / r) * dx / (r * d);
+                // the bottom of the bowl is a cone tip, its slope is taken as 0
+                if (slopesX && distance > 0.0f) {
+                    float k = 2.0f * pitDepth * edge / (pitRadius * distance);
+                    slopesX[i] += k * dx;
+                    slopesZ[i] += k * dz;
+                }
+            }
+        }
+    }
+}
+
+// Heights and normals of rows [zBegin, zEnd), columns [xBegin, xEnd]: base heightfield plus
+// the pits reaching them, normals from the analytic slopes of both
+static void computeRows(TerrainGrid& grid, int xBegin, int xEnd, int zBegin, int zEnd,
+    const std::vector<HazardZone>& pits)
+{
+    const int rowLength = grid.getRowLength();
+    const int count = xEnd - xBegin + 1;
+
+    std::vector<float> rowX(count), rowZ(count), slopesX(count), slopesZ(count);
+    for (int x = 0; x < count; ++x)
+        rowX[x] = grid.getCoordinate(xBegin + x);
+
+    // Only pits reaching this block of rows are rasterized into it
+    std::vector<int> blockPits;
+    findPitsInRect(pits, rowX[0], grid.getCoordinate(zBegin), rowX[count - 1], grid.getCoordinate(zEnd - 1), blockPits);
+
+    for (int z = zBegin; z < zEnd; ++z) {
+        float fz = grid.getCoordinate(z);
+        size_t rowStart = static_cast<size_t>(z) * rowLength + xBegin;
+        float* rowHeights = &grid.heights[rowStart];
+        glm::vec3* rowNormals = &grid.normals[rowStart];
+
+        std::fill(rowZ.begin(), rowZ.end(), fz);
+        evaluateTerrainHeightsAndSlopes(rowX.data(), rowZ.data(), rowHeights, slopesX.data(), slopesZ.data(), count);
+        carvePitsRow(rowX.data(), count, grid.getSpacing(), fz, rowHeights, slopesX.data(), slopesZ.data(), pits, blockPits);
+
+        for (int x = 0; x < count; ++x)
+            rowNormals[x] = glm::normalize(glm::vec3(-slopesX[x], 1.0f, -slopesZ[x]));
+    }
+}
+
+TerrainGrid buildTerrainGrid(float size, int divisions, const std::vector<HazardZone>& pits)
+{
+    TerrainGrid grid;
+    grid.size = size;
+    grid.divisions = divisions;
+
+    const int rowLength = grid.getRowLength();
+
+    grid.heights.resize(static_cast<size_t>(rowLength) * rowLength);
+    grid.normals.resize(static_cast<size_t>(rowLength) * rowLength);
+
+    // Rows are independent: normals come from analytic slopes, not from neighbouring heights
+    ThreadPool::shared().parallelFor(0, rowLength, TERRAIN_ROWS_PER_BAND, [&](int zBegin, int zEnd) {
+        computeRows(grid, 0, divisions, zBegin, zEnd, pits);
+    });
+
+    return grid;
+}
+
+TerrainRegion getPitRegion(const TerrainGrid& grid, const HazardZone& pit)
+{
+    // Same padding as findPitsInRect, plus one vertex for rounding in getCoordinate
+    float reach = pit.size.x / 2.0f * 1.0001f;
+    float spacing = grid.getSpacing();
+
+    TerrainRegion region;
+    region.x0 = std::max(0, (int)std::floor((pit.position.x - reach + grid.size) / spacing) - 1);
+    region.z0 = std::max(0, (int)std::floor((pit.position.z - reach + grid.size) / spacing) - 1);
+    region.x1 = std::min(grid.divisions, (int)std::ceil((pit.position.x + reach + grid.size) / spacing) + 1);
+    region.z1 = std::min(grid.divisions, (int)std::ceil((pit.position.z + reach + grid.size) / spacing) + 1);
+    return region;
+}
+
+TerrainRegion recarveTerrainRegion(TerrainGrid& grid, const TerrainRegion& region, const std::vector<HazardZone>& pits)
+{
+    if (region.isEmpty())
+        return region;
+
+    ThreadPool::shared().parallelFor(region.z0, region.z1 + 1, TERRAIN_ROWS_PER_BAND, [&](int zBegin, int zEnd) {
+        computeRows(grid, region.x0, region.x1, zBegin, zEnd, pits);
+    });
+
+    return region;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <glm.hpp>
+#include "..\GameState.h"
+#include "heightfield.h"
+
+// CPU copy of the terrain: a (divisions + 1)^2 grid of heights and normals spanning
+// [-size, size] on X and Z, with the hazard pits carved in. Rows run along +X, row z
+// starts at index z * getRowLength().
+struct TerrainGrid
+{
+    float size;
+    int divisions;
+    std::vector<float> heights;
+    std::vector<glm::vec3> normals;
+
+    int getRowLength() const { return divisions + 1; }
+    float getSpacing() const { return 2.0f * size / (float)divisions; }
+    float getCoordinate(int i) const { return -size + 2.0f * size * (float)i / (float)divisions; }
+};
+
+// Inclusive block of grid vertices (or HazardMask texels), [x0, x1] x [z0, z1]
+struct TerrainRegion
+{
+    int x0, z0;
+    int x1, z1;
+
+    bool isEmpty() const { return x1 < x0 || z1 < z0; }
+    int getWidth() const { return x1 - x0 + 1; }
+    int getHeight() const { return z1 - z0 + 1; }
+};
+
+// Smallest block covering both, either of which may be empty
+inline TerrainRegion mergeRegions(const TerrainRegion& a, const TerrainRegion& b)
+{
+    if (a.isEmpty())
+        return b;
+    if (b.isEmpty())
+        return a;
+    TerrainRegion merged = { std::min(a.x0, b.x0), std::min(a.z0, b.z0), std::max(a.x1, b.x1), std::max(a.z1, b.z1) };
+    return merged;
+}
+
+// Lowers a base height by every pit covering (x, z): a bowl of radius size.x / 2 and depth 4
+float carvePits(float x, float z, float height, const std::vector<HazardZone>& pits);
+
+// Appends, in ascending order, the indices of the pits whose bounding square overlaps
+// [minX, maxX] x [minZ, maxZ]
+void findPitsInRect(const std::vector<HazardZone>& pits, float minX, float minZ, float maxX, float maxZ,
+    std::vector<int>& candidates);
+
+// Carves one row of heights sampled at xs (ascending, evenly spaced by spacing) and z.
+// Only the listed candidate pits are considered, each over the columns under its bounding
+// square, so the cost follows the pit footprint instead of samples x pits. Every sample
+// sees its pits in the same order as carvePits(), so the heights are identical.
+// When slopesX / slopesZ are given, each pit's analytic dh/dx and dh/dz are added to them.
+void carvePitsRow(const float* xs, int count, float spacing, float z, float* heights, float* slopesX, float* slopesZ,
+    const std::vector<HazardZone>& pits, const std::vector<int>& candidates);
+
+// Heights and normals come out of one pass: normals use the analytic slopes of the heightfield
+// and of the pit bowls, so a row never reads its neighbours and every vertex (chunk borders
+// included) gets its exact normal. Rows are split into bands and built on
+// ThreadPool::shared(); the result is identical to a serial build.
+TerrainGrid buildTerrainGrid(float size, int divisions, const std::vector<HazardZone>& pits);
+
+// Grid vertices whose height a pit can change (its bounding square, padded for rounding)
+TerrainRegion getPitRegion(const TerrainGrid& grid, const HazardZone& pit);
+
+// Rebuilds heights and normals inside region from the heightfield and the current pits.
+// Returns the block that was rewritten (region itself, normals do not reach past it).
+// Used when a pit is added or removed after the initial build.
+TerrainRegion recarveTerrainRegion(TerrainGrid& grid, const TerrainRegion& region, const std::vector<HazardZone>& pits);
@@ -0,0 +1,196 @@
+#include "terrainCache.h"
+#include "..\Utils\hash.h"
+#include "..\Utils\mappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+static const char TERRAIN_CACHE_MAGIC[4] = { 'T', 'R', 'N', 'C' };
+
+// Sections start on this boundary so every array in the mapped file is aligned
+static const uint64_t TERRAIN_CACHE_ALIGNMENT = 16;
+
+// Fixed-size header at the start of the file, followed by the sections it points to
+struct TerrainCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    float size;
+    int32_t divisions;
+    float minHeight;
+    float heightScale;
+    int32_t leavesPerSide;
+    uint32_t reserved;
+    uint64_t heightsOffset;         // float per grid vertex
+    uint64_t normalsOffset;         // glm::vec3 per grid vertex
+    uint64_t texelHeightsOffset;    // GLushort per grid vertex
+    uint64_t texelNormalsOffset;    // 2 GLbyte per grid vertex
+    uint64_t leafRangesOffset;      // glm::vec2 per leaf node
+    uint64_t fileSize;
+};
+
+struct TerrainCacheSection
+{
+    uint64_t TerrainCacheHeader::*offset;
+    const void* data;
+    uint64_t bytes;
+};
+
+static uint64_t alignOffset(uint64_t offset)
+{
+    return (offset + TERRAIN_CACHE_ALIGNMENT - 1) & ~(TERRAIN_CACHE_ALIGNMENT - 1);
+}
+
+uint64_t computeTerrainCacheKey(float size, int divisions, const std::vector<HazardZone>& pits)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hashBytes(hash, &TERRAIN_CACHE_VERSION, sizeof(TERRAIN_CACHE_VERSION));
+    hashBytes(hash, &size, sizeof(size));
+    hashBytes(hash, &divisions, sizeof(divisions));
+
+    uint64_t pitCount = pits.size();
+    hashBytes(hash, &pitCount, sizeof(pitCount));
+    for (const auto& pit : pits) {
+        hashBytes(hash, &pit.position[0], sizeof(float) * 3);
+        hashBytes(hash, &pit.size[0], sizeof(float) * 3);
+    }
+    return hash;
+}
+
+static bool writeTerrainCache(const std::string& path, uint64_t key, const TerrainGrid& grid, const TerrainLODData& data)
+{
+    const uint64_t vertexCount = static_cast<uint64_t>(grid.getRowLength()) * grid.getRowLength();
+    const uint64_t leafCount = static_cast<uint64_t>(data.leavesPerSide) * data.leavesPerSide;
+
+    TerrainCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TERRAIN_CACHE_MAGIC, sizeof(header.magic));
+    header.version = TERRAIN_CACHE_VERSION;
+    header.key = key;
+    header.size = grid.size;
+    header.divisions = grid.divisions;
+    header.minHeight = data.minHeight;
+    header.heightScale = data.heightScale;
+    header.leavesPerSide = data.leavesPerSide;
+
+    TerrainCacheSection sections[] = {
+        { &TerrainCacheHeader::heightsOffset, &grid.heights[0], vertexCount * sizeof(float) },
+        { &TerrainCacheHeader::normalsOffset, &grid.normals[0], vertexCount * sizeof(glm::vec3) },
+        { &TerrainCacheHeader::texelHeightsOffset, data.heights, vertexCount * sizeof(GLushort) },
+        { &TerrainCacheHeader::texelNormalsOffset, data.normals, vertexCount * 2 * sizeof(GLbyte) },
+        { &TerrainCacheHeader::leafRangesOffset, data.leafHeightRanges, leafCount * sizeof(glm::vec2) },
+    };
+
+    uint64_t offset = alignOffset(sizeof(header));
+    for (const auto& section : sections) {
+        header.*section.offset = offset;
+        offset = alignOffset(offset + section.bytes);
+    }
+    header.fileSize = offset;
+
+    // Written next to the target and renamed, so a crash never leaves a half-written cache
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        const char padding[TERRAIN_CACHE_ALIGNMENT] = {};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        uint64_t written = sizeof(header);
+
+        for (const auto& section : sections) {
+            file.write(padding, static_cast<std::streamsize>(header.*section.offset - written));
+            file.write(static_cast<const char*>(section.data), static_cast<std::streamsize>(section.bytes));
+            written = header.*section.offset + section.bytes;
+        }
+        file.write(padding, static_cast<std::streamsize>(header.fileSize - written));
+
+        if (!file)
+            return false;
+    }
+
+    std::remove(path.c_str());
+    return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
+
+// Checks that the mapped file is a complete cache for exactly these inputs
+static const TerrainCacheHeader* validateTerrainCache(const MappedFile& file, uint64_t key, float size, int divisions)
+{
+    if (file.getSize() < sizeof(TerrainCacheHeader))
+        return nullptr;
+
+    const TerrainCacheHeader* header = reinterpret_cast<const TerrainCacheHeader*>(file.getData());
+    if (std::memcmp(header->magic, TERRAIN_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TERRAIN_CACHE_VERSION ||
+        header->key != key ||
+        header->size != size ||
+        header->divisions != divisions ||
+        header->fileSize != file.getSize())
+        return nullptr;
+
+    const uint64_t vertexCount = static_cast<uint64_t>(divisions + 1) * (divisions + 1);
+    const uint64_t leafCount = static_cast<uint64_t>(header->leavesPerSide) * header->leavesPerSide;
+    const uint64_t ends[] = {
+        header->heightsOffset + vertexCount * sizeof(float),
+        header->normalsOffset + vertexCount * sizeof(glm::vec3),
+        header->texelHeightsOffset + vertexCount * sizeof(GLushort),
+        header->texelNormalsOffset + vertexCount * 2 * sizeof(GLbyte),
+        header->leafRangesOffset + leafCount * sizeof(glm::vec2),
+    };
+    for (uint64_t end : ends) {
+        if (end > header->fileSize)
+            return nullptr;
+    }
+    return header;
+}
+
+TerrainLOD* loadOrBuildTerrainLOD(const std::string& path, float size, int divisions,
+    const std::vector<HazardZone>& pits, GLuint textureID, TerrainGrid& grid, bool& loadedFromCache)
+{
+    const uint64_t key = computeTerrainCacheKey(size, divisions, pits);
+
+    MappedFile file;
+    const TerrainCacheHeader* header = file.open(path) ? validateTerrainCache(file, key, size, divisions) : nullptr;
+
+    if (header) {
+        const unsigned char* base = file.getData();
+        const size_t vertexCount = static_cast<size_t>(divisions + 1) * (divisions + 1);
+
+        grid.size = size;
+        grid.divisions = divisions;
+
+        const float* heights = reinterpret_cast<const float*>(base + header->heightsOffset);
+        const glm::vec3* normals = reinterpret_cast<const glm::vec3*>(base + header->normalsOffset);
+        grid.heights.assign(heights, heights + vertexCount);
+        grid.normals.assign(normals, normals + vertexCount);
+
+        TerrainLODData data;
+        data.minHeight = header->minHeight;
+        data.heightScale = header->heightScale;
+        data.rowLength = divisions + 1;
+        data.leavesPerSide = header->leavesPerSide;
+        data.heights = reinterpret_cast<const GLushort*>(base + header->texelHeightsOffset);
+        data.normals = reinterpret_cast<const GLbyte*>(base + header->texelNormalsOffset);
+        data.leafHeightRanges = reinterpret_cast<const glm::vec2*>(base + header->leafRangesOffset);
+
+        loadedFromCache = true;
+        return new TerrainLOD(size, data, textureID);
+    }
+    file.close();
+
+    grid = buildTerrainGrid(size, divisions, pits);
+
+    std::vector<GLushort> texelHeights;
+    std::vector<GLbyte> texelNormals;
+    std::vector<glm::vec2> leafHeightRanges;
+    TerrainLODData data = TerrainLOD::pack(grid, texelHeights, texelNormals, leafHeightRanges);
+
+    if (!writeTerrainCache(path, key, grid, data))
+        std::cout << "Could not write terrain cache " << path << std::endl;
+
+    loadedFromCache = false;
+    return new TerrainLOD(size, data, textureID);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glew.h>
+#include "terrain.h"
+#include "terrainLOD.h"
+
+// On-disk cache of the fixed-size terrain: the CPU grid and the packed quadtree data in one
+// versioned binary file, keyed by a hash of everything they are built from. A matching file
+// is memory-mapped and its sections are copied / uploaded as they are, with no per-vertex
+// work; a missing or stale file is rebuilt and rewritten.
+
+// Bump whenever the heightfield, pit carving or TerrainLODData formats change
+const uint32_t TERRAIN_CACHE_VERSION = 1;
+
+// Hash of the build inputs: size, divisions and the position and size of every pit
+uint64_t computeTerrainCacheKey(float size, int divisions, const std::vector<HazardZone>& pits);
+
+// Fills grid and returns a new TerrainLOD, from the file at path when it matches, otherwise
+// built from scratch (and the file rewritten). loadedFromCache tells which one happened.
+TerrainLOD* loadOrBuildTerrainLOD(const std::string& path, float size, int divisions,
+    const std::vector<HazardZone>& pits, GLuint textureID, TerrainGrid& grid, bool& loadedFromCache);
@@ -0,0 +1,305 @@
+#include "terrainClipmap.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Vertices per ring side, 2^k - 1 so a level's window is exactly half of the next level's
+static const int CLIPMAP_SIZE = 127;
+static const int CLIPMAP_HALF = (CLIPMAP_SIZE + 1) / 2;
+static const int CLIPMAP_LEVELS = 6;
+
+// Vertex spacing of the finest level, matches the fixed-size terrain grid
+static const float CLIPMAP_BASE_SPACING = 4.0f;
+
+// The hole a level leaves for the finer one starts at this cell, +1 when the finer origin / 2 is odd
+static const int CLIPMAP_HOLE_START = CLIPMAP_HALF / 2;
+static const int CLIPMAP_HOLE_CELLS = (CLIPMAP_SIZE - 1) / 2;
+
+static int floorDiv(float value, float divisor)
+{
+    return static_cast<int>(std::floor(value / divisor));
+}
+
+static int wrap(int value)
+{
+    int m = value % CLIPMAP_SIZE;
+    return m < 0 ? m + CLIPMAP_SIZE : m;
+}
+
+// Even grid origin keeps a level's vertices on every other vertex of the next coarser level
+static int levelOrigin(float cameraCoord, float spacing)
+{
+    return 2 * floorDiv(cameraCoord, 2.0f * spacing) - CLIPMAP_HALF;
+}
+
+static GLuint createIndexBuffer(const std::vector<int>& indices)
+{
+    GLuint ibo;
+    glGenBuffers(1, &ibo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    return ibo;
+}
+
+// Two triangles per cell, skipping the cells covered by the finer level when holeX >= 0
+static std::vector<int> createGridIndices(int holeX, int holeZ)
+{
+    std::vector<int> indices;
+
+    for (int z = 0; z < CLIPMAP_SIZE - 1; ++z) {
+        for (int x = 0; x < CLIPMAP_SIZE - 1; ++x) {
+            if (holeX >= 0 &&
+                x >= holeX && x < holeX + CLIPMAP_HOLE_CELLS &&
+                z >= holeZ && z < holeZ + CLIPMAP_HOLE_CELLS)
+                continue;
+
+            int i0 = z * CLIPMAP_SIZE + x;
+            int i1 = i0 + 1;
+            int i2 = i0 + CLIPMAP_SIZE;
+            int i3 = i2 + 1;
+
+            indices.push_back(i0);
+            indices.push_back(i2);
+            indices.push_back(i1);
+
+            indices.push_back(i1);
+            indices.push_back(i2);
+            indices.push_back(i3);
+        }
+    }
+
+    return indices;
+}
+
+TerrainClipmap::TerrainClipmap(GLuint textureID, const std::vector<HazardZone>& pits)
+    : pits(pits)
+    , sandTexture(textureID)
+    , updatedSamples(0)
+{
+    uniforms.program = 0;
+
+    levels.resize(CLIPMAP_LEVELS);
+    for (int i = 0; i < CLIPMAP_LEVELS; ++i) {
+        Level& level = levels[i];
+        level.spacing = CLIPMAP_BASE_SPACING * (float)(1 << i);
+        level.originX = 0;
+        level.originZ = 0;
+        level.valid = false;
+        level.samples.assign(CLIPMAP_SIZE * CLIPMAP_SIZE, glm::vec3(0.0f));
+
+        glGenTextures(1, &level.heightMap);
+        glBindTexture(GL_TEXTURE_2D, level.heightMap);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB32F, CLIPMAP_SIZE, CLIPMAP_SIZE, 0, GL_RGB, GL_FLOAT, &level.samples[0]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Shared ring geometry: index buffers only, the vertex shader turns gl_VertexID
+    // (= z * CLIPMAP_SIZE + x) into the local grid position
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    std::vector<int> fullIndices = createGridIndices(-1, -1);
+    fullIndexCount = static_cast<int>(fullIndices.size());
+    fullIbo = createIndexBuffer(fullIndices);
+
+    for (int parity = 0; parity < 4; ++parity) {
+        std::vector<int> ringIndices = createGridIndices(CLIPMAP_HOLE_START + parity % 2, CLIPMAP_HOLE_START + parity / 2);
+        ringIndexCount = static_cast<int>(ringIndices.size());
+        ringIbo[parity] = createIndexBuffer(ringIndices);
+    }
+
+    glBindVertexArray(0);
+}
+
+TerrainClipmap::~TerrainClipmap()
+{
+    for (auto& level : levels)
+        glDeleteTextures(1, &level.heightMap);
+
+    glDeleteBuffers(1, &fullIbo);
+    glDeleteBuffers(4, ringIbo);
+    glDeleteVertexArrays(1, &vao);
+}
+
+int TerrainClipmap::getLevelCount() const
+{
+    return CLIPMAP_LEVELS;
+}
+
+int TerrainClipmap::getTriangleCount() const
+{
+    return (fullIndexCount + ringIndexCount * (CLIPMAP_LEVELS - 1)) / 3;
+}
+
+void TerrainClipmap::invalidate()
+{
+    for (auto& level : levels)
+        level.valid = false;
+}
+
+void TerrainClipmap::update(const glm::vec3& cameraPos)
+{
+    updatedSamples = 0;
+
+    for (auto& level : levels) {
+        int newX = levelOrigin(cameraPos.x, level.spacing);
+        int newZ = levelOrigin(cameraPos.z, level.spacing);
+
+        if (!level.valid ||
+            std::abs(newX - level.originX) >= CLIPMAP_SIZE ||
+            std::abs(newZ - level.originZ) >= CLIPMAP_SIZE) {
+            level.originX = newX;
+            level.originZ = newZ;
+            level.valid = true;
+            refreshRegion(level, newX, newZ, newX + CLIPMAP_SIZE, newZ + CLIPMAP_SIZE);
+            continue;
+        }
+
+        // Columns that entered the window, over the full new height
+        if (newX > level.originX)
+            refreshRegion(level, level.originX + CLIPMAP_SIZE, newZ, newX + CLIPMAP_SIZE, newZ + CLIPMAP_SIZE);
+        else if (newX < level.originX)
+            refreshRegion(level, newX, newZ, level.originX, newZ + CLIPMAP_SIZE);
+
+        // Rows that entered the window, only over the columns kept from before
+        int keptX0 = std::max(newX, level.originX);
+        int keptX1 = std::min(newX, level.originX) + CLIPMAP_SIZE;
+
+        if (newZ > level.originZ)
+            refreshRegion(level, keptX0, level.originZ + CLIPMAP_SIZE, keptX1, newZ + CLIPMAP_SIZE);
+        else if (newZ < level.originZ)
+            refreshRegion(level, keptX0, newZ, keptX1, level.originZ);
+
+        level.originX = newX;
+        level.originZ = newZ;
+    }
+}
+
+// Evaluates the samples of grid rectangle [gx0, gx1) x [gz0, gz1) into the mirror and uploads them
+void TerrainClipmap::refreshRect(float minX, float minZ, float maxX, float maxZ)
+{
+    for (auto& level : levels) {
+        if (!level.valid)
+            continue;
+
+        // One extra sample on each side, re-evaluating it is cheaper than reasoning about rounding
+        int gx0 = std::max(level.originX, floorDiv(minX, level.spacing));
+        int gz0 = std::max(level.originZ, floorDiv(minZ, level.spacing));
+        int gx1 = std::min(level.originX + CLIPMAP_SIZE, floorDiv(maxX, level.spacing) + 2);
+        int gz1 = std::min(level.originZ + CLIPMAP_SIZE, floorDiv(maxZ, level.spacing) + 2);
+
+        refreshRegion(level, gx0, gz0, gx1, gz1);
+    }
+}
+
+void TerrainClipmap::refreshRegion(Level& level, int gx0, int gz0, int gx1, int gz1)
+{
+    if (gx1 <= gx0 || gz1 <= gz0)
+        return;
+
+    int width = gx1 - gx0;
+    std::vector<float> xs(width), zs(width), heights(width), slopesX(width), slopesZ(width);
+    for (int i = 0; i < width; ++i)
+        xs[i] = (float)(gx0 + i) * level.spacing;
+
+    std::vector<int> candidates;
+    findPitsInRect(pits, xs[0], (float)gz0 * level.spacing, xs[width - 1], (float)(gz1 - 1) * level.spacing, candidates);
+
+    for (int gz = gz0; gz < gz1; ++gz) {
+        float z = (float)gz * level.spacing;
+        std::fill(zs.begin(), zs.end(), z);
+        evaluateTerrainHeightsAndSlopes(xs.data(), zs.data(), heights.data(), slopesX.data(), slopesZ.data(), width);
+        carvePitsRow(xs.data(), width, level.spacing, z, heights.data(), slopesX.data(), slopesZ.data(), pits, candidates);
+
+        glm::vec3* row = &level.samples[wrap(gz) * CLIPMAP_SIZE];
+        for (int i = 0; i < width; ++i)
+            row[wrap(gx0 + i)] = glm::vec3(heights[i], slopesX[i], slopesZ[i]);
+    }
+
+    updatedSamples += width * (gz1 - gz0);
+    uploadRegion(level, gx0, gz0, gx1, gz1);
+}
+
+// Uploads a grid rectangle, split into up to four texture rectangles where it wraps around
+void TerrainClipmap::uploadRegion(Level& level, int gx0, int gz0, int gx1, int gz1)
+{
+    glBindTexture(GL_TEXTURE_2D, level.heightMap);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, CLIPMAP_SIZE);
+
+    int tx0 = wrap(gx0);
+    int tz0 = wrap(gz0);
+    int width = gx1 - gx0;
+    int height = gz1 - gz0;
+
+    int xSpans[2][2] = { { tx0, std::min(width, CLIPMAP_SIZE - tx0) }, { 0, width - std::min(width, CLIPMAP_SIZE - tx0) } };
+    int zSpans[2][2] = { { tz0, std::min(height, CLIPMAP_SIZE - tz0) }, { 0, height - std::min(height, CLIPMAP_SIZE - tz0) } };
+
+    for (int zi = 0; zi < 2; ++zi) {
+        for (int xi = 0; xi < 2; ++xi) {
+            if (xSpans[xi][1] == 0 || zSpans[zi][1] == 0)
+                continue;
+
+            glPixelStorei(GL_UNPACK_SKIP_PIXELS, xSpans[xi][0]);
+            glPixelStorei(GL_UNPACK_SKIP_ROWS, zSpans[zi][0]);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, xSpans[xi][0], zSpans[zi][0], xSpans[xi][1], zSpans[zi][1],
+                GL_RGB, GL_FLOAT, &level.samples[0]);
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TerrainClipmap::draw(Shader& shader)
+{
+    if (uniforms.program != shader.getId()) {
+        uniforms.program = shader.getId();
+        uniforms.levelOrigin = shader.getUniform("levelOrigin");
+        uniforms.levelTexOffset = shader.getUniform("levelTexOffset");
+        uniforms.levelSpacing = shader.getUniform("levelSpacing");
+        uniforms.texture1 = shader.getUniform("texture1");
+        uniforms.heightMap = shader.getUniform("heightMap");
+        uniforms.clipmapSize = shader.getUniform("clipmapSize");
+    }
+
+    shader.setInt(uniforms.texture1, 0);
+    shader.setInt(uniforms.heightMap, 1);
+    shader.setInt(uniforms.clipmapSize, CLIPMAP_SIZE);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sandTexture);
+    glActiveTexture(GL_TEXTURE1);
+
+    glBindVertexArray(vao);
+
+    for (int i = 0; i < CLIPMAP_LEVELS; ++i) {
+        const Level& level = levels[i];
+
+        GLuint ibo = fullIbo;
+        int indexCount = fullIndexCount;
+        if (i > 0) {
+            // Where the finer window sits inside this one depends on the finer origin's parity
+            const Level& finer = levels[i - 1];
+            int parityX = ((finer.originX + CLIPMAP_HALF) / 2) & 1;
+            int parityZ = ((finer.originZ + CLIPMAP_HALF) / 2) & 1;
+            ibo = ringIbo[parityX + 2 * parityZ];
+            indexCount = ringIndexCount;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, level.heightMap);
+        shader.setVec2(uniforms.levelOrigin, glm::vec2((float)level.originX, (float)level.originZ));
+        shader.setIVec2(uniforms.levelTexOffset, glm::ivec2(wrap(level.originX), wrap(level.originZ)));
+        shader.setFloat(uniforms.levelSpacing, level.spacing);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    }
+
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+}
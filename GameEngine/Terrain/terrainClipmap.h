@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <glew.h>
+#include <glm.hpp>
+#include "..\Shaders\shader.h"
+#include "terrain.h"
+
+// Geometry-clipmap terrain for worlds without a fixed size. Nested square rings of
+// CLIPMAP_SIZE^2 vertices follow the camera, each level with twice the spacing of the
+// previous one. A level's heights and analytic slopes live in a toroidally addressed
+// texture: when the camera crosses a grid line only the newly exposed rows and columns are
+// evaluated and written with glTexSubImage2D, so memory and per-frame cost do not depend
+// on the world size.
+class TerrainClipmap
+{
+public:
+    // pits must stay alive while the clipmap is in use, new strips are carved from it
+    TerrainClipmap(GLuint textureID, const std::vector<HazardZone>& pits);
+    ~TerrainClipmap();
+
+    void update(const glm::vec3& cameraPos);
+    void draw(Shader& shader);
+
+    // Marks every level for a full refresh on the next update()
+    void invalidate();
+
+    // Re-evaluates the samples inside [minX, maxX] x [minZ, maxZ] on every level right away,
+    // e.g. under a pit that was just added or removed
+    void refreshRect(float minX, float minZ, float maxX, float maxZ);
+
+    int getLevelCount() const;
+    int getTriangleCount() const;
+    int getUpdatedSampleCount() const { return updatedSamples; }
+
+private:
+    TerrainClipmap(const TerrainClipmap&);
+    TerrainClipmap& operator=(const TerrainClipmap&);
+
+    struct Level
+    {
+        float spacing;
+        int originX;            // grid coordinates (in units of spacing) of the ring's min corner
+        int originZ;
+        bool valid;
+        GLuint heightMap;
+        std::vector<glm::vec3> samples;   // (height, dh/dx, dh/dz), CPU mirror in texture (toroidal) layout
+    };
+
+    void refreshRegion(Level& level, int gx0, int gz0, int gx1, int gz1);
+    void uploadRegion(Level& level, int gx0, int gz0, int gx1, int gz1);
+
+    const std::vector<HazardZone>& pits;
+    GLuint sandTexture;
+    std::vector<Level> levels;
+
+    GLuint vao;
+    GLuint fullIbo;
+    GLuint ringIbo[4];          // indexed by hole offset parity: x + 2 * z
+    int fullIndexCount;
+    int ringIndexCount;
+
+    int updatedSamples;
+
+    // Uniform handles in the program last drawn with, looked up again when it changes
+    struct DrawUniforms
+    {
+        int program;
+        GLint levelOrigin, levelTexOffset, levelSpacing;
+        GLint texture1, heightMap, clipmapSize;
+    };
+    DrawUniforms uniforms;
+};
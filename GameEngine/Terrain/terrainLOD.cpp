@@ -0,0 +1,475 @@
+#include "terrainLOD.h"
+#include <algorithm>
+#include <cmath>
+
+// Quads per side of a node patch; finest nodes match the grid spacing when
+// divisions / TERRAIN_PATCH_RESOLUTION is a power of two
+static const int TERRAIN_PATCH_RESOLUTION = 32;
+
+// Finest level is drawn within this many leaf-node sizes of the camera, each coarser level doubles it
+static const float TERRAIN_LOD_RANGE_SCALE = 2.0f;
+
+// Fraction of a level's distance band after which its vertices start morphing to the coarser grid
+static const float TERRAIN_MORPH_START_RATIO = 0.66f;
+
+TerrainLOD::Patch TerrainLOD::createPatch(int resolution)
+{
+    std::vector<unsigned int> indices;
+
+    for (int z = 0; z < resolution; ++z) {
+        for (int x = 0; x < resolution; ++x) {
+            unsigned int i0 = z * (resolution + 1) + x;
+            unsigned int i1 = i0 + 1;
+            unsigned int i2 = i0 + (resolution + 1);
+            unsigned int i3 = i2 + 1;
+
+            indices.push_back(i0);
+            indices.push_back(i2);
+            indices.push_back(i1);
+
+            indices.push_back(i1);
+            indices.push_back(i2);
+            indices.push_back(i3);
+        }
+    }
+
+    Patch patch;
+    patch.resolution = resolution;
+    patch.indexCount = static_cast<int>(indices.size());
+
+    // No attributes: the vertex shader turns gl_VertexID (the index value) into a grid position
+    glGenVertexArrays(1, &patch.vao);
+    glGenBuffers(1, &patch.ibo);
+    glBindVertexArray(patch.vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, patch.ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    return patch;
+}
+
+// Octahedral encoding around +Y: the upper hemisphere maps to the inner diamond,
+// the lower one is folded over the corners
+static void encodeOctahedral(const glm::vec3& n, GLbyte* out)
+{
+    float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+    float u = n.x / l1;
+    float v = n.z / l1;
+
+    if (n.y < 0.0f) {
+        float foldedU = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        float foldedV = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+        u = foldedU;
+        v = foldedV;
+    }
+
+    out[0] = static_cast<GLbyte>(std::floor(glm::clamp(u, -1.0f, 1.0f) * 127.0f + 0.5f));
+    out[1] = static_cast<GLbyte>(std::floor(glm::clamp(v, -1.0f, 1.0f) * 127.0f + 0.5f));
+}
+
+static bool boxIntersectsSphere(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::vec3& center, float radius)
+{
+    glm::vec3 closest = glm::clamp(center, boxMin, boxMax);
+    glm::vec3 d = closest - center;
+    return glm::dot(d, d) <= radius * radius;
+}
+
+// Smallest and largest height inside region
+static void computeHeightBounds(const TerrainGrid& grid, const TerrainRegion& region, float& low, float& high)
+{
+    const int rowLength = grid.getRowLength();
+
+    low = grid.heights[region.z0 * rowLength + region.x0];
+    high = low;
+    for (int z = region.z0; z <= region.z1; ++z) {
+        for (int x = region.x0; x <= region.x1; ++x) {
+            float h = grid.heights[z * rowLength + x];
+            low = std::min(low, h);
+            high = std::max(high, h);
+        }
+    }
+}
+
+// Quantized heights and octahedral normals of region, rows packed tightly
+static void packTexels(const TerrainGrid& grid, const TerrainRegion& region, float minHeight, float heightScale,
+    GLushort* heights, GLbyte* normals)
+{
+    const int rowLength = grid.getRowLength();
+
+    size_t t = 0;
+    for (int z = region.z0; z <= region.z1; ++z) {
+        for (int x = region.x0; x <= region.x1; ++x, ++t) {
+            int idx = z * rowLength + x;
+
+            float normalized = (grid.heights[idx] - minHeight) / heightScale;
+            heights[t] = static_cast<GLushort>(std::floor(glm::clamp(normalized, 0.0f, 1.0f) * 65535.0f + 0.5f));
+            encodeOctahedral(grid.normals[idx], &normals[t * 2]);
+        }
+    }
+}
+
+TerrainLOD::TerrainLOD(const TerrainGrid& grid, GLuint textureID)
+    : worldSize(grid.size)
+    , sandTexture(textureID)
+{
+    std::vector<GLushort> heights;
+    std::vector<GLbyte> normals;
+    std::vector<glm::vec2> leafHeightRanges;
+    initialize(pack(grid, heights, normals, leafHeightRanges));
+}
+
+TerrainLOD::TerrainLOD(float size, const TerrainLODData& data, GLuint textureID)
+    : worldSize(size)
+    , sandTexture(textureID)
+{
+    initialize(data);
+}
+
+TerrainLODData TerrainLOD::pack(const TerrainGrid& grid, std::vector<GLushort>& heights,
+    std::vector<GLbyte>& normals, std::vector<glm::vec2>& leafHeightRanges)
+{
+    TerrainLODData data;
+    data.rowLength = grid.getRowLength();
+    data.leavesPerSide = computeLeavesPerSide(grid.divisions);
+
+    TerrainRegion all = { 0, 0, grid.divisions, grid.divisions };
+    float low, high;
+    computeHeightBounds(grid, all, low, high);
+    data.minHeight = low;
+    data.heightScale = std::max(high - low, 1e-4f);
+
+    size_t texelCount = static_cast<size_t>(data.rowLength) * data.rowLength;
+    heights.resize(texelCount);
+    normals.resize(texelCount * 2);
+    packTexels(grid, all, data.minHeight, data.heightScale, &heights[0], &normals[0]);
+
+    leafHeightRanges.resize(data.leavesPerSide * data.leavesPerSide);
+    for (int nz = 0; nz < data.leavesPerSide; ++nz)
+        for (int nx = 0; nx < data.leavesPerSide; ++nx)
+            leafHeightRanges[nz * data.leavesPerSide + nx] = computeLeafHeightRange(grid, data.leavesPerSide, nx, nz);
+
+    data.heights = &heights[0];
+    data.normals = &normals[0];
+    data.leafHeightRanges = &leafHeightRanges[0];
+    return data;
+}
+
+void TerrainLOD::initialize(const TerrainLODData& data)
+{
+    uniforms.program = 0;
+
+    heightMapSize = data.rowLength;
+    leavesPerSide = data.leavesPerSide;
+    minHeight = data.minHeight;
+    heightScale = data.heightScale;
+
+    levelCount = 1;
+    while ((1 << (levelCount - 1)) < leavesPerSide)
+        levelCount++;
+
+    // Height range of every node, leaves as given and parents from their children
+    nodeHeightRange.resize(levelCount);
+    nodeHeightRange[0].assign(data.leafHeightRanges, data.leafHeightRanges + leavesPerSide * leavesPerSide);
+
+    for (int level = 1; level < levelCount; ++level) {
+        int nodesPerSide = leavesPerSide >> level;
+
+        nodeHeightRange[level].resize(nodesPerSide * nodesPerSide);
+        for (int nz = 0; nz < nodesPerSide; ++nz)
+            for (int nx = 0; nx < nodesPerSide; ++nx)
+                nodeHeightRange[level][nz * nodesPerSide + nx] = computeParentHeightRange(level, nx, nz);
+    }
+
+    lodRanges.resize(levelCount);
+    float range = getNodeSize(0) * TERRAIN_LOD_RANGE_SCALE;
+    for (int level = 0; level < levelCount; ++level) {
+        lodRanges[level] = range;
+        range *= 2.0f;
+    }
+
+    // Both maps are sampled with bilinear filtering by the vertex shader
+    glGenTextures(1, &heightMap);
+    glBindTexture(GL_TEXTURE_2D, heightMap);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, heightMapSize, heightMapSize, 0, GL_RED, GL_UNSIGNED_SHORT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+    glGenTextures(1, &normalMap);
+    glBindTexture(GL_TEXTURE_2D, normalMap);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8_SNORM, heightMapSize, heightMapSize, 0, GL_RG, GL_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    uploadRect(0, 0, heightMapSize, heightMapSize, data.heights, data.normals);
+
+    fullPatch = createPatch(TERRAIN_PATCH_RESOLUTION);
+    halfPatch = createPatch(TERRAIN_PATCH_RESOLUTION / 2);
+}
+
+int TerrainLOD::computeLeavesPerSide(int divisions)
+{
+    int leaves = 1;
+    while (leaves * 2 * TERRAIN_PATCH_RESOLUTION <= divisions)
+        leaves *= 2;
+    return leaves;
+}
+
+glm::vec2 TerrainLOD::computeLeafHeightRange(const TerrainGrid& grid, int leavesPerSide, int nodeX, int nodeZ)
+{
+    const float cellsPerLeaf = (float)grid.divisions / (float)leavesPerSide;
+
+    TerrainRegion leaf;
+    leaf.x0 = static_cast<int>(std::floor(nodeX * cellsPerLeaf));
+    leaf.x1 = std::min(grid.divisions, static_cast<int>(std::ceil((nodeX + 1) * cellsPerLeaf)));
+    leaf.z0 = static_cast<int>(std::floor(nodeZ * cellsPerLeaf));
+    leaf.z1 = std::min(grid.divisions, static_cast<int>(std::ceil((nodeZ + 1) * cellsPerLeaf)));
+
+    glm::vec2 range;
+    computeHeightBounds(grid, leaf, range.x, range.y);
+    return range;
+}
+
+glm::vec2 TerrainLOD::computeParentHeightRange(int level, int nodeX, int nodeZ) const
+{
+    int childrenPerSide = (leavesPerSide >> level) * 2;
+    const std::vector<glm::vec2>& children = nodeHeightRange[level - 1];
+
+    glm::vec2 range = children[(nodeZ * 2) * childrenPerSide + nodeX * 2];
+    for (int c = 1; c < 4; ++c) {
+        const glm::vec2& child = children[(nodeZ * 2 + c / 2) * childrenPerSide + nodeX * 2 + c % 2];
+        range.x = std::min(range.x, child.x);
+        range.y = std::max(range.y, child.y);
+    }
+    return range;
+}
+
+// Widens the quantization range when the region holds heights outside it (a new pit deeper
+// than anything before). Returns true when the range changed and every texel must be redone.
+bool TerrainLOD::fitHeightRange(const TerrainGrid& grid, const TerrainRegion& region)
+{
+    float low, high;
+    computeHeightBounds(grid, region, low, high);
+
+    if (low >= minHeight && high <= minHeight + heightScale)
+        return false;
+
+    // Leave headroom so a series of deeper pits does not requantize every time
+    low = std::min(low, minHeight);
+    high = std::max(high, minHeight + heightScale);
+    float margin = 0.25f * (high - low);
+
+    minHeight = low - margin;
+    heightScale = (high + margin) - minHeight;
+    return true;
+}
+
+void TerrainLOD::uploadTexels(const TerrainGrid& grid, const TerrainRegion& region)
+{
+    const size_t texelCount = static_cast<size_t>(region.getWidth()) * region.getHeight();
+
+    std::vector<GLushort> heights(texelCount);
+    std::vector<GLbyte> normals(texelCount * 2);
+    packTexels(grid, region, minHeight, heightScale, &heights[0], &normals[0]);
+
+    uploadRect(region.x0, region.z0, region.getWidth(), region.getHeight(), &heights[0], &normals[0]);
+}
+
+void TerrainLOD::uploadRect(int x, int z, int width, int height, const GLushort* heights, const GLbyte* normals)
+{
+    // Rows of 2-byte texels are not 4-byte aligned for odd widths
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    glBindTexture(GL_TEXTURE_2D, heightMap);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, z, width, height, GL_RED, GL_UNSIGNED_SHORT, heights);
+
+    glBindTexture(GL_TEXTURE_2D, normalMap);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, z, width, height, GL_RG, GL_BYTE, normals);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void TerrainLOD::updateRegion(const TerrainGrid& grid, const TerrainRegion& region)
+{
+    if (region.isEmpty())
+        return;
+
+    if (fitHeightRange(grid, region)) {
+        TerrainRegion all = { 0, 0, grid.divisions, grid.divisions };
+        uploadTexels(grid, all);
+    }
+    else {
+        uploadTexels(grid, region);
+    }
+
+    // Leaves touching the region; a leaf also owns the vertex on its far edge,
+    // so the one before a boundary vertex is included too
+    const float cellsPerLeaf = (float)grid.divisions / (float)leavesPerSide;
+    int nx0 = std::max(0, static_cast<int>(std::floor(region.x0 / cellsPerLeaf)) - 1);
+    int nz0 = std::max(0, static_cast<int>(std::floor(region.z0 / cellsPerLeaf)) - 1);
+    int nx1 = std::min(leavesPerSide - 1, static_cast<int>(std::floor(region.x1 / cellsPerLeaf)));
+    int nz1 = std::min(leavesPerSide - 1, static_cast<int>(std::floor(region.z1 / cellsPerLeaf)));
+
+    for (int nz = nz0; nz <= nz1; ++nz)
+        for (int nx = nx0; nx <= nx1; ++nx)
+            nodeHeightRange[0][nz * leavesPerSide + nx] = computeLeafHeightRange(grid, leavesPerSide, nx, nz);
+
+    for (int level = 1; level < levelCount; ++level) {
+        int nodesPerSide = leavesPerSide >> level;
+        for (int nz = nz0 >> level; nz <= (nz1 >> level); ++nz)
+            for (int nx = nx0 >> level; nx <= (nx1 >> level); ++nx)
+                nodeHeightRange[level][nz * nodesPerSide + nx] = computeParentHeightRange(level, nx, nz);
+    }
+}
+
+TerrainLOD::~TerrainLOD()
+{
+    glDeleteTextures(1, &heightMap);
+    glDeleteTextures(1, &normalMap);
+
+    const Patch* patches[] = { &fullPatch, &halfPatch };
+    for (const Patch* patch : patches) {
+        glDeleteBuffers(1, &patch->ibo);
+        glDeleteVertexArrays(1, &patch->vao);
+    }
+}
+
+float TerrainLOD::getNodeSize(int level) const
+{
+    return 2.0f * worldSize / (float)(1 << (levelCount - 1 - level));
+}
+
+void TerrainLOD::getNodeBounds(int level, int nodeX, int nodeZ, glm::vec3& boxMin, glm::vec3& boxMax) const
+{
+    float nodeSize = getNodeSize(level);
+    int nodesPerSide = 1 << (levelCount - 1 - level);
+    const glm::vec2& range = nodeHeightRange[level][nodeZ * nodesPerSide + nodeX];
+
+    boxMin = glm::vec3(-worldSize + nodeX * nodeSize, range.x, -worldSize + nodeZ * nodeSize);
+    boxMax = glm::vec3(boxMin.x + nodeSize, range.y, boxMin.z + nodeSize);
+}
+
+void TerrainLOD::select(const glm::vec3& cameraPos, const glm::mat4& viewProjection)
+{
+    selectionCameraPos = cameraPos;
+    selectionFrustum.extract(viewProjection);
+    selection.clear();
+
+    selectNode(levelCount - 1, 0, 0);
+}
+
+// Returns false when the node is out of its level's range, so the parent has to cover it
+bool TerrainLOD::selectNode(int level, int nodeX, int nodeZ)
+{
+    glm::vec3 boxMin, boxMax;
+    getNodeBounds(level, nodeX, nodeZ, boxMin, boxMax);
+
+    if (!boxIntersectsSphere(boxMin, boxMax, selectionCameraPos, lodRanges[level]))
+        return false;
+
+    if (!selectionFrustum.intersectsBox(boxMin, boxMax))
+        return true;
+
+    float nodeSize = boxMax.x - boxMin.x;
+    TerrainNode node = { glm::vec2(boxMin.x, boxMin.z), nodeSize, level, false };
+
+    if (level == 0 || !boxIntersectsSphere(boxMin, boxMax, selectionCameraPos, lodRanges[level - 1])) {
+        selection.push_back(node);
+        return true;
+    }
+
+    // Children closer than the finer range refine further, the rest stay at this level
+    for (int c = 0; c < 4; ++c) {
+        int childX = nodeX * 2 + c % 2;
+        int childZ = nodeZ * 2 + c / 2;
+
+        if (!selectNode(level - 1, childX, childZ)) {
+            glm::vec3 childMin, childMax;
+            getNodeBounds(level - 1, childX, childZ, childMin, childMax);
+
+            if (selectionFrustum.intersectsBox(childMin, childMax)) {
+                TerrainNode quarter = { glm::vec2(childMin.x, childMin.z), nodeSize * 0.5f, level, true };
+                selection.push_back(quarter);
+            }
+        }
+    }
+
+    return true;
+}
+
+int TerrainLOD::getSelectedTriangleCount() const
+{
+    int triangles = 0;
+    for (const auto& node : selection)
+        triangles += (node.halfResolution ? halfPatch.indexCount : fullPatch.indexCount) / 3;
+    return triangles;
+}
+
+size_t TerrainLOD::getGpuMemoryBytes() const
+{
+    size_t texels = static_cast<size_t>(heightMapSize) * heightMapSize;
+    size_t indices = static_cast<size_t>(fullPatch.indexCount) + halfPatch.indexCount;
+    return texels * (sizeof(GLushort) + 2 * sizeof(GLbyte)) + indices * sizeof(unsigned int);
+}
+
+void TerrainLOD::draw(Shader& shader)
+{
+    if (uniforms.program != shader.getId()) {
+        uniforms.program = shader.getId();
+        uniforms.nodeOrigin = shader.getUniform("nodeOrigin");
+        uniforms.nodeSize = shader.getUniform("nodeSize");
+        uniforms.patchResolution = shader.getUniform("patchResolution");
+        uniforms.morphRange = shader.getUniform("morphRange");
+        uniforms.texture1 = shader.getUniform("texture1");
+        uniforms.heightMap = shader.getUniform("heightMap");
+        uniforms.normalMap = shader.getUniform("normalMap");
+        uniforms.heightRange = shader.getUniform("heightRange");
+        uniforms.worldSize = shader.getUniform("worldSize");
+        uniforms.heightMapSize = shader.getUniform("heightMapSize");
+        uniforms.lodCameraPos = shader.getUniform("lodCameraPos");
+    }
+
+    shader.setInt(uniforms.texture1, 0);
+    shader.setInt(uniforms.heightMap, 1);
+    shader.setInt(uniforms.normalMap, 2);
+    shader.setVec2(uniforms.heightRange, glm::vec2(minHeight, heightScale));
+    shader.setFloat(uniforms.worldSize, worldSize);
+    shader.setFloat(uniforms.heightMapSize, (float)heightMapSize);
+    shader.setVec3(uniforms.lodCameraPos, selectionCameraPos);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sandTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, heightMap);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, normalMap);
+
+    for (const auto& node : selection) {
+        const Patch& patch = node.halfResolution ? halfPatch : fullPatch;
+
+        float morphEnd = lodRanges[node.level];
+        float morphStart = node.level > 0 ? lodRanges[node.level - 1] : 0.0f;
+        morphStart += (morphEnd - morphStart) * TERRAIN_MORPH_START_RATIO;
+
+        shader.setVec2(uniforms.nodeOrigin, node.origin);
+        shader.setFloat(uniforms.nodeSize, node.size);
+        shader.setFloat(uniforms.patchResolution, (float)patch.resolution);
+        shader.setVec2(uniforms.morphRange, glm::vec2(morphStart, morphEnd));
+
+        glBindVertexArray(patch.vao);
+        glDrawElements(GL_TRIANGLES, patch.indexCount, GL_UNSIGNED_INT, 0);
+    }
+
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
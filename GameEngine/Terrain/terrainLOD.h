@@ -0,0 +1,125 @@
+#pragma once
+
+#include <vector>
+#include <glew.h>
+#include <glm.hpp>
+#include "..\Shaders\shader.h"
+#include "..\Camera\frustum.h"
+#include "terrain.h"
+
+// Everything TerrainLOD uploads and keeps, in its GPU formats. Produced by TerrainLOD::pack()
+// and stored by the terrain cache; the pointers may point into a memory-mapped cache file.
+struct TerrainLODData
+{
+    float minHeight;                    // heights are minHeight + heightScale * (value / 65535)
+    float heightScale;
+    int rowLength;                      // grid vertices per side
+    int leavesPerSide;
+    const GLushort* heights;            // rowLength^2 quantized heights
+    const GLbyte* normals;              // rowLength^2 octahedral normals, 2 bytes each
+    const glm::vec2* leafHeightRanges;  // leavesPerSide^2 (min, max) per finest node
+};
+
+// One selected quadtree node, drawn with a single patch draw call
+struct TerrainNode
+{
+    glm::vec2 origin;       // world XZ of the node's min corner
+    float size;             // world extent along X and Z
+    int level;              // 0 = finest
+    bool halfResolution;    // quarter of a level + 1 node, drawn with the coarser patch
+};
+
+// Chunked quadtree LOD terrain (CDLOD). The grid lives in two compact textures, a 16-bit
+// quantized height and an octahedral-packed 8:8 normal (4 bytes per vertex). Every node is
+// the same patch placed and scaled in the vertex shader (terrain_vertex_shader.glsl), which
+// rebuilds patch positions from gl_VertexID, so the patches have no vertex buffer at all.
+// Nodes are picked each frame from the camera position: level L covers everything within
+// lodRanges[L], and vertices morph to the next coarser grid as they approach that range so
+// neighbouring levels meet without cracks.
+class TerrainLOD
+{
+public:
+    TerrainLOD(const TerrainGrid& grid, GLuint textureID);
+
+    // Uploads already packed data as is, with no per-vertex work; size is the grid's size
+    TerrainLOD(float size, const TerrainLODData& data, GLuint textureID);
+    ~TerrainLOD();
+
+    // Packs a grid into the vectors, which the returned data points into
+    static TerrainLODData pack(const TerrainGrid& grid, std::vector<GLushort>& heights,
+        std::vector<GLbyte>& normals, std::vector<glm::vec2>& leafHeightRanges);
+
+    void select(const glm::vec3& cameraPos, const glm::mat4& viewProjection);
+    void draw(Shader& shader);
+
+    // Re-uploads a block of the grid that changed after construction (see recarveTerrainRegion)
+    // and refreshes the height ranges of the nodes above it
+    void updateRegion(const TerrainGrid& grid, const TerrainRegion& region);
+
+    int getLevelCount() const { return levelCount; }
+    int getSelectedNodeCount() const { return static_cast<int>(selection.size()); }
+    int getSelectedTriangleCount() const;
+
+    // Texture and index buffer memory owned by the terrain
+    size_t getGpuMemoryBytes() const;
+
+private:
+    TerrainLOD(const TerrainLOD&);
+    TerrainLOD& operator=(const TerrainLOD&);
+
+    void initialize(const TerrainLODData& data);
+
+    static int computeLeavesPerSide(int divisions);
+    static glm::vec2 computeLeafHeightRange(const TerrainGrid& grid, int leavesPerSide, int nodeX, int nodeZ);
+    glm::vec2 computeParentHeightRange(int level, int nodeX, int nodeZ) const;
+    void uploadTexels(const TerrainGrid& grid, const TerrainRegion& region);
+    void uploadRect(int x, int z, int width, int height, const GLushort* heights, const GLbyte* normals);
+    bool fitHeightRange(const TerrainGrid& grid, const TerrainRegion& region);
+
+    // Index-only patch, vertex positions come from gl_VertexID
+    struct Patch
+    {
+        GLuint vao;
+        GLuint ibo;
+        int resolution;
+        int indexCount;
+    };
+
+    static Patch createPatch(int resolution);
+
+    bool selectNode(int level, int nodeX, int nodeZ);
+    void getNodeBounds(int level, int nodeX, int nodeZ, glm::vec3& boxMin, glm::vec3& boxMax) const;
+    float getNodeSize(int level) const;
+
+    float worldSize;
+    int heightMapSize;
+    int levelCount;
+    int leavesPerSide;
+
+    // nodeHeightRange[level][nodeZ * nodesPerSide + nodeX] = (min height, max height)
+    std::vector<std::vector<glm::vec2>> nodeHeightRange;
+    std::vector<float> lodRanges;
+
+    // Heights are stored as minHeight + heightScale * (value / 65535)
+    float minHeight;
+    float heightScale;
+
+    GLuint heightMap;       // R16, quantized height
+    GLuint normalMap;       // RG8_SNORM, octahedral normal
+    GLuint sandTexture;
+    Patch fullPatch;
+    Patch halfPatch;
+
+    glm::vec3 selectionCameraPos;
+    Frustum selectionFrustum;
+    std::vector<TerrainNode> selection;
+
+    // Uniform handles in the program last drawn with, looked up again when it changes
+    struct DrawUniforms
+    {
+        int program;
+        GLint nodeOrigin, nodeSize, patchResolution, morphRange;
+        GLint texture1, heightMap, normalMap, heightRange, worldSize, heightMapSize, lodCameraPos;
+    };
+    DrawUniforms uniforms;
+};
@@ -0,0 +1,240 @@
+#include "terrainRaycast.h"
+#include "..\Utils\threadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Rays per band handed to a worker by the batched query
+static const int RAYCAST_RAYS_PER_BAND = 64;
+
+// Positions are nudged this far (in cells) along the ray when picking the next node, so a
+// ray sitting exactly on a node border lands in the node it is entering
+static const double RAYCAST_CELL_NUDGE = 1e-9;
+
+TerrainHeightPyramid::TerrainHeightPyramid(const TerrainGrid& grid)
+    : grid(grid)
+{
+    int width = grid.divisions;
+    levelWidths.push_back(width);
+    levels.push_back(std::vector<float>(static_cast<size_t>(width) * width));
+
+    while (width > 1) {
+        width = (width + 1) / 2;
+        levelWidths.push_back(width);
+        levels.push_back(std::vector<float>(static_cast<size_t>(width) * width));
+    }
+
+    TerrainRegion all = { 0, 0, grid.divisions, grid.divisions };
+    updateRegion(all);
+}
+
+float TerrainHeightPyramid::getCellMax(int cellX, int cellZ) const
+{
+    const int rowLength = grid.getRowLength();
+    const float* row = &grid.heights[static_cast<size_t>(cellZ) * rowLength + cellX];
+    return std::max(std::max(row[0], row[1]), std::max(row[rowLength], row[rowLength + 1]));
+}
+
+void TerrainHeightPyramid::updateRegion(const TerrainRegion& region)
+{
+    if (region.isEmpty())
+        return;
+
+    // Cells touching the region's vertices
+    int x0 = std::max(0, region.x0 - 1);
+    int z0 = std::max(0, region.z0 - 1);
+    int x1 = std::min(grid.divisions - 1, region.x1);
+    int z1 = std::min(grid.divisions - 1, region.z1);
+
+    for (int z = z0; z <= z1; ++z)
+        for (int x = x0; x <= x1; ++x)
+            levels[0][z * levelWidths[0] + x] = getCellMax(x, z);
+
+    for (size_t level = 1; level < levels.size(); ++level) {
+        x0 >>= 1; z0 >>= 1; x1 >>= 1; z1 >>= 1;
+
+        const std::vector<float>& below = levels[level - 1];
+        const int belowWidth = levelWidths[level - 1];
+        const int width = levelWidths[level];
+
+        for (int z = z0; z <= z1; ++z) {
+            for (int x = x0; x <= x1; ++x) {
+                float h = -std::numeric_limits<float>::max();
+                for (int c = 0; c < 4; ++c) {
+                    int bx = x * 2 + c % 2;
+                    int bz = z * 2 + c / 2;
+                    if (bx < belowWidth && bz < belowWidth)
+                        h = std::max(h, below[bz * belowWidth + bx]);
+                }
+                levels[level][z * width + x] = h;
+            }
+        }
+    }
+}
+
+// Moller-Trumbore against the cell's two triangles, split from (x + 1, z) to (x, z + 1)
+// like the terrain index buffers
+bool TerrainHeightPyramid::intersectCell(int cellX, int cellZ, const glm::dvec3& origin, const glm::dvec3& direction,
+    double tMin, double tMax, double& tHit, glm::vec3& normal) const
+{
+    const int rowLength = grid.getRowLength();
+    const size_t i00 = static_cast<size_t>(cellZ) * rowLength + cellX;
+
+    glm::dvec3 p00(grid.getCoordinate(cellX), grid.heights[i00], grid.getCoordinate(cellZ));
+    glm::dvec3 p10(grid.getCoordinate(cellX + 1), grid.heights[i00 + 1], p00.z);
+    glm::dvec3 p01(p00.x, grid.heights[i00 + rowLength], grid.getCoordinate(cellZ + 1));
+    glm::dvec3 p11(p10.x, grid.heights[i00 + rowLength + 1], p01.z);
+
+    const glm::dvec3* triangles[2][3] = { { &p00, &p01, &p10 }, { &p10, &p01, &p11 } };
+
+    bool found = false;
+    for (int i = 0; i < 2; ++i) {
+        const glm::dvec3& a = *triangles[i][0];
+        glm::dvec3 edge1 = *triangles[i][1] - a;
+        glm::dvec3 edge2 = *triangles[i][2] - a;
+
+        glm::dvec3 p = glm::cross(direction, edge2);
+        double det = glm::dot(edge1, p);
+        if (std::fabs(det) < 1e-12)
+            continue;
+
+        double invDet = 1.0 / det;
+        glm::dvec3 s = origin - a;
+        double u = glm::dot(s, p) * invDet;
+        if (u < 0.0 || u > 1.0)
+            continue;
+
+        glm::dvec3 q = glm::cross(s, edge1);
+        double v = glm::dot(direction, q) * invDet;
+        if (v < 0.0 || u + v > 1.0)
+            continue;
+
+        double t = glm::dot(edge2, q) * invDet;
+        if (t < tMin || t > tMax || (found && t >= tHit))
+            continue;
+
+        // Upward facing normal, whichever winding the triangle has
+        glm::dvec3 n = glm::normalize(glm::cross(edge1, edge2));
+        if (n.y < 0.0)
+            n = -n;
+
+        tHit = t;
+        normal = glm::vec3(n);
+        found = true;
+    }
+    return found;
+}
+
+TerrainHit TerrainHeightPyramid::raycast(const TerrainRay& ray) const
+{
+    TerrainHit result;
+    result.hit = false;
+    result.distance = 0.0f;
+    result.position = glm::vec3(0.0f);
+    result.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+
+    const glm::dvec3 origin(ray.origin);
+    const glm::dvec3 direction(ray.direction);
+    const double spacing = grid.getSpacing();
+    const int cells = grid.divisions;
+    const int top = static_cast<int>(levels.size()) - 1;
+
+    // The ray in cell units on X and Z, world units on Y
+    const double cellX = (origin.x + grid.size) / spacing;
+    const double cellZ = (origin.z + grid.size) / spacing;
+    const double stepX = direction.x / spacing;
+    const double stepZ = direction.z / spacing;
+
+    // Clip to the grid's footprint
+    double tEnter = 0.0;
+    double tExit = ray.maxDistance;
+    const double starts[2] = { cellX, cellZ };
+    const double steps[2] = { stepX, stepZ };
+    for (int axis = 0; axis < 2; ++axis) {
+        if (steps[axis] == 0.0) {
+            if (starts[axis] < 0.0 || starts[axis] > cells)
+                return result;
+            continue;
+        }
+        double t0 = (0.0 - starts[axis]) / steps[axis];
+        double t1 = (cells - starts[axis]) / steps[axis];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        tEnter = std::max(tEnter, t0);
+        tExit = std::min(tExit, t1);
+    }
+    if (tEnter > tExit)
+        return result;
+
+    const double nudgeX = stepX > 0.0 ? RAYCAST_CELL_NUDGE : (stepX < 0.0 ? -RAYCAST_CELL_NUDGE : 0.0);
+    const double nudgeZ = stepZ > 0.0 ? RAYCAST_CELL_NUDGE : (stepZ < 0.0 ? -RAYCAST_CELL_NUDGE : 0.0);
+
+    double t = tEnter;
+    int level = top;
+
+    while (t <= tExit) {
+        int x = static_cast<int>(std::floor(cellX + stepX * t + nudgeX));
+        int z = static_cast<int>(std::floor(cellZ + stepZ * t + nudgeZ));
+        x = std::min(std::max(x, 0), cells - 1);
+        z = std::min(std::max(z, 0), cells - 1);
+
+        // Node containing the current cell and where the ray leaves it
+        int nodeX = x >> level;
+        int nodeZ = z >> level;
+        int nodeCells = 1 << level;
+
+        double tNodeExit = tExit;
+        if (stepX != 0.0) {
+            double boundary = stepX > 0.0 ? std::min((nodeX + 1) * nodeCells, cells) : nodeX * nodeCells;
+            tNodeExit = std::min(tNodeExit, (boundary - cellX) / stepX);
+        }
+        if (stepZ != 0.0) {
+            double boundary = stepZ > 0.0 ? std::min((nodeZ + 1) * nodeCells, cells) : nodeZ * nodeCells;
+            tNodeExit = std::min(tNodeExit, (boundary - cellZ) / stepZ);
+        }
+        tNodeExit = std::max(tNodeExit, t);
+
+        // Lowest point of the ray over the node, against the node's highest vertex
+        double lowest = origin.y + direction.y * (direction.y < 0.0 ? tNodeExit : t);
+        float nodeMax = levels[level][nodeZ * levelWidths[level] + nodeX];
+
+        if (lowest > nodeMax) {
+            // Entirely above: skip the node and try to stride wider from the next one
+            if (tNodeExit >= tExit)
+                break;
+            t = tNodeExit;
+            level = std::min(level + 1, top);
+            continue;
+        }
+
+        if (level > 0) {
+            level--;
+            continue;
+        }
+
+        double tHit;
+        glm::vec3 normal;
+        if (intersectCell(x, z, origin, direction, t - 1e-6, tNodeExit + 1e-6, tHit, normal)) {
+            result.hit = true;
+            result.distance = static_cast<float>(tHit);
+            result.position = glm::vec3(origin + direction * tHit);
+            result.normal = normal;
+            return result;
+        }
+
+        if (tNodeExit >= tExit)
+            break;
+        t = tNodeExit;
+        level = std::min(1, top);
+    }
+
+    return result;
+}
+
+void TerrainHeightPyramid::raycast(const TerrainRay* rays, TerrainHit* hits, int count) const
+{
+    ThreadPool::shared().parallelFor(0, count, RAYCAST_RAYS_PER_BAND, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+            hits[i] = raycast(rays[i]);
+    });
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <glm.hpp>
+#include "terrain.h"
+
+struct TerrainRay
+{
+    glm::vec3 origin;
+    glm::vec3 direction;    // normalized
+    float maxDistance;
+};
+
+struct TerrainHit
+{
+    bool hit;
+    float distance;         // along the ray, valid when hit
+    glm::vec3 position;
+    glm::vec3 normal;       // of the triangle that was hit
+};
+
+// Max-mip pyramid over a TerrainGrid for ray casts against the ground (line of sight,
+// camera probes, picking). Level 0 holds the highest corner of every grid cell, each level
+// above the maximum of 2x2 nodes below. A ray walks the pyramid top-down and skips every
+// node it passes entirely above, so it only tests the triangles of the few cells it
+// actually reaches. Hits are exact against the grid's triangles, split like the rendered mesh.
+class TerrainHeightPyramid
+{
+public:
+    // grid must stay alive while the pyramid is used, heights are read from it
+    explicit TerrainHeightPyramid(const TerrainGrid& grid);
+
+    // First point where the ray crosses the terrain from above within maxDistance
+    TerrainHit raycast(const TerrainRay& ray) const;
+
+    // hits[i] = raycast(rays[i]), spread over ThreadPool::shared()
+    void raycast(const TerrainRay* rays, TerrainHit* hits, int count) const;
+
+    // Refreshes the maxima above a block of grid vertices after recarveTerrainRegion
+    void updateRegion(const TerrainRegion& region);
+
+    int getLevelCount() const { return static_cast<int>(levels.size()); }
+
+private:
+    bool intersectCell(int cellX, int cellZ, const glm::dvec3& origin, const glm::dvec3& direction,
+        double tMin, double tMax, double& tHit, glm::vec3& normal) const;
+    float getCellMax(int cellX, int cellZ) const;
+
+    const TerrainGrid& grid;
+    std::vector<int> levelWidths;               // nodes per side
+    std::vector<std::vector<float>> levels;     // levels[0] = per cell
+};
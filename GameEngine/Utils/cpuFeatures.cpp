@@ -0,0 +1,54 @@
+#include "cpuFeatures.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_FEATURES_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+#ifdef CPU_FEATURES_X86
+
+// AVX2 needs the CPU flag and an OS that saves the YMM registers
+static bool cpuHasAVX2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    __cpuid(info, 1);
+    bool osUsesXSave = (info[2] & (1 << 27)) != 0;
+    bool hasAVX = (info[2] & (1 << 28)) != 0;
+    if (!osUsesXSave || !hasAVX || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif // CPU_FEATURES_X86
+
+SimdPath getSimdPath()
+{
+#ifdef CPU_FEATURES_X86
+    static const SimdPath path = cpuHasAVX2() ? SimdPath::AVX2 : SimdPath::SSE2;
+    return path;
+#else
+    return SimdPath::Scalar;
+#endif
+}
+
+const char* getSimdPathName(SimdPath path)
+{
+    switch (path) {
+    case SimdPath::AVX2: return "AVX2";
+    case SimdPath::SSE2: return "SSE2";
+    default: return "scalar";
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// Instruction set paths shared by the SIMD kernels (heightfield, AABB overlap).
+// Every kernel also has a scalar path, used on non-x86 builds.
+enum class SimdPath
+{
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// Widest path supported by this CPU, detected once
+SimdPath getSimdPath();
+const char* getSimdPathName(SimdPath path);
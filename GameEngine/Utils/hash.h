@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// FNV-1a, 64 bit: start from FNV_OFFSET_BASIS and feed every input in a fixed order.
+// Used for cache keys and state checksums, never for anything that needs to be secure.
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+inline void hashBytes(uint64_t& hash, const void* data, size_t bytes)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < bytes; ++i) {
+        hash ^= p[i];
+        hash *= 1099511628211ull;
+    }
+}
@@ -0,0 +1,129 @@
+#include "threadPool.h"
+
+static thread_local bool insideBand = false;
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+    : job(nullptr)
+    , jobBegin(0)
+    , jobEnd(0)
+    , jobBandSize(1)
+    , bandCount(0)
+    , nextBand(0)
+    , bandsFinished(0)
+    , activeWorkers(0)
+    , generation(0)
+    , stopping(false)
+{
+    if (threadCount == 0) {
+        unsigned int cores = std::thread::hardware_concurrency();
+        threadCount = cores > 1 ? cores - 1 : 0;
+    }
+
+    for (unsigned int i = 0; i < threadCount; ++i)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+unsigned int ThreadPool::getThreadCount() const
+{
+    return static_cast<unsigned int>(workers.size());
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::parallelFor(int begin, int end, int bandSize, const std::function<void(int, int)>& body)
+{
+    if (end <= begin)
+        return;
+    if (bandSize < 1)
+        bandSize = 1;
+
+    int bands = (end - begin + bandSize - 1) / bandSize;
+
+    if (workers.empty() || bands == 1 || insideBand) {
+        body(begin, end);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submitLock(submitMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        job = &body;
+        jobBegin = begin;
+        jobEnd = end;
+        jobBandSize = bandSize;
+        bandCount = bands;
+        bandsFinished = 0;
+        nextBand.store(0);
+        generation++;
+    }
+    jobReady.notify_all();
+
+    runBands();
+
+    std::unique_lock<std::mutex> lock(jobMutex);
+    jobDone.wait(lock, [this] { return bandsFinished == bandCount && activeWorkers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::runBands()
+{
+    insideBand = true;
+
+    int finished = 0;
+    for (;;) {
+        int band = nextBand.fetch_add(1);
+        if (band >= bandCount)
+            break;
+
+        int bandBegin = jobBegin + band * jobBandSize;
+        int bandEnd = bandBegin + jobBandSize < jobEnd ? bandBegin + jobBandSize : jobEnd;
+        (*job)(bandBegin, bandEnd);
+        finished++;
+    }
+
+    insideBand = false;
+
+    std::lock_guard<std::mutex> lock(jobMutex);
+    bandsFinished += finished;
+}
+
+void ThreadPool::workerLoop()
+{
+    unsigned int seenGeneration = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobReady.wait(lock, [&] { return stopping || (job != nullptr && generation != seenGeneration); });
+            if (stopping)
+                return;
+            seenGeneration = generation;
+            activeWorkers++;
+        }
+
+        runBands();
+
+        // the submitting thread may only reset the job once every worker has left it
+        std::lock_guard<std::mutex> lock(jobMutex);
+        activeWorkers--;
+        if (activeWorkers == 0 && bandsFinished == bandCount)
+            jobDone.notify_all();
+    }
+}
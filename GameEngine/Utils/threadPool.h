@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool used to split grid-shaped work (terrain rows, ray batches...)
+// into contiguous bands. The calling thread also works on bands, so a pool created
+// with N threads keeps N + 1 cores busy.
+class ThreadPool
+{
+public:
+    // threadCount == 0 picks hardware_concurrency() - 1 workers
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    // Runs body(bandBegin, bandEnd) over [begin, end) split into bands of at most
+    // bandSize items and returns once every band has finished. Calls made from inside
+    // a band (nested parallelFor) run serially on the calling thread.
+    void parallelFor(int begin, int end, int bandSize, const std::function<void(int, int)>& body);
+
+    unsigned int getThreadCount() const;
+
+    // Pool shared by the engine subsystems, created on first use
+    static ThreadPool& shared();
+
+private:
+    void workerLoop();
+    void runBands();
+
+    std::vector<std::thread> workers;
+
+    std::mutex submitMutex;
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+
+    const std::function<void(int, int)>* job;
+    int jobBegin;
+    int jobEnd;
+    int jobBandSize;
+    int bandCount;
+    std::atomic<int> nextBand;
+    int bandsFinished;
+    int activeWorkers;
+    unsigned int generation;
+    bool stopping;
+};
@@ -1,24 +1,60 @@
 ﻿#include "Graphics/window.h"
 #include "Camera/camera.h"
 #include "Shaders/shader.h"
+#include "Shaders/uniformBuffer.h"
+#include "Shaders/hazardTextures.h"
 #include "Model Loading/mesh.h"
 #include "Model Loading/texture.h"
 #include "Model Loading/meshLoaderObj.h"
+#include "Terrain/terrain.h"
+#include "Terrain/terrainLOD.h"
+#include "Terrain/terrainClipmap.h"
+#include "Terrain/terrainCache.h"
+#include "Terrain/terrainRaycast.h"
+#include "Terrain/hazardMask.h"
+#include "Physics/aabbBatch.h"
+#include "Physics/characterController.h"
+#include "Physics/dynamicAabbTree.h"
+#include "Physics/meshBvh.h"
+#include "Physics/obb.h"
+#include "Benchmarks/benchmarks.h"
+#include "Input/inputFrame.h"
+#include "Input/inputLog.h"
+#include "Utils/hash.h"
 #include "GameState.h"
+#include <algorithm>
 #include <iostream>
 #include <vector>
+#include <map>
 #include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <random>
 
 // Function declarations
 void processKeyboardInput();
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void drawHeartsHUD(int livesLeft);
+void refreshTerrainUnderPit(const HazardZone& pit);
+void processObjectEditInput();
+void simulationStep();
+int  advanceFrame(const InputFrame& frame);
+void buildLevel(std::vector<Mesh>& staticMeshes);
+void scatterProps(std::vector<Mesh>& staticMeshes, int count);
+int  runHeadless(int ticks, const InputLog* replay);
 
 // Global variables
-float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// Simulation runs in fixed steps whatever the frame rate; frames longer than
+// MAX_FRAME_TIME (a breakpoint, a hitch) are clamped instead of replayed step by step
+const float SIM_TIMESTEP = 1.0f / 120.0f;
+const float MAX_FRAME_TIME = 0.25f;
+long long simTick = 0;              // steps run so far; sim time is simTick * SIM_TIMESTEP
+float simAccumulator = 0.0f;
+glm::vec3 previousSimPosition;      // camera position before the latest step
+
 const float GROUND_Y = 10.0f;
 const float JUMP_SPEED = 35.0f;
 const float GRAVITY = -90.0f;
@@ -26,7 +62,29 @@ const float CROUCH_OFFSET = 4.0f;
 const float EYE_OFFSET = 2.0f;
 const float STAND_HEIGHT = GROUND_Y + EYE_OFFSET;
 const float CROUCH_HEIGHT = GROUND_Y - CROUCH_OFFSET + EYE_OFFSET;
-Window window("Alien Artifact Recovery", 1920, 1080);
+
+// Clipmap terrain is streamed around the camera and has no world edge;
+// the quadtree LOD terrain covers the fixed 2000x2000 map. The clipmap is an
+// experimental renderer only: it keeps no CPU heights, so with it there is no
+// terrain pyramid and crosshair pit placement falls back to a fixed distance.
+const bool USE_CLIPMAP_TERRAIN = false;
+
+// The fixed-size terrain is rebuilt only when its size, divisions or pits change; the
+// cache path is relative to the working directory, like the shader and resource paths
+const char* TERRAIN_CACHE_PATH = "terrain.cache";
+const float TERRAIN_SIZE = 1000.0f;
+const int   TERRAIN_DIVISIONS = 512;
+
+// Texels per side of the baked hazard mask over the same area (about one per world unit)
+const int   HAZARD_MASK_RESOLUTION = 2048;
+
+// Crate models, each with a <name>_Mat_BaseColor.bmp texture next to it
+const char* CRATE_MODEL_DIRECTORY = "Resources/Models/StaticObjects/crates/";
+const char* CRATE_MODELS[] = { "Crate_1x1", "Crate_1x1_Tall", "Crate_1x2", "Crate_1x2_Tall", "Crate_2x2_Tall" };
+
+// Created by main for the windowed game only; headless runs and benchmarks have no
+// window and no GL context
+Window* window = nullptr;
 Camera camera(glm::vec3(0.0f, STAND_HEIGHT, 780.0f));
 
 GameState gameState;
@@ -49,6 +107,17 @@ float lastX = 1280.0f / 2.0f;
 float lastY = 720.0f / 2.0f;
 bool  firstMouse = true;
 
+// Input of the frame being simulated; cursor and wheel movement gathered by the
+// callbacks until the next frame takes them
+InputFrame input;
+float pendingMouseX = 0.0f;
+float pendingMouseY = 0.0f;
+float pendingScroll = 0.0f;
+
+// Headless runs simulate thousands of times faster than real time, without the
+// per-event messages
+bool logSimulationEvents = true;
+
 // Camera FOV (zoom)
 float fov = 100.0f;  
 
@@ -59,7 +128,7 @@ int lives = maxLives;
 
 // Pit fall state
 bool  isFallingInPit = false;
-float fallStartTime = 0.0f;
+long long fallStartTick = 0;
 float fallDuration = 2.0f;
 glm::vec3 respawnPoint = glm::vec3(0.0f, STAND_HEIGHT, 780.0f);
 
@@ -69,13 +138,79 @@ struct ObjectInstance {
     glm::vec3 position;
     glm::vec3 scale;
     float rotationY;
+    Obb worldBox;       // cached by addObject / updateObjectBounds
+    const MeshBvh* collisionMesh;   // set by addObject, shared by every instance of mesh
+    glm::mat4 model;    // cached by addObject / updateObjectBounds
+
+    // The authored fields; the cached ones are filled in by addObject
+    ObjectInstance(Mesh* mesh, const glm::vec3& position, const glm::vec3& scale, float rotationY)
+        : mesh(mesh), position(position), scale(scale), rotationY(rotationY)
+        , worldBox(), collisionMesh(nullptr), model(1.0f)
+    {
+    }
 };
 
 std::vector<ObjectInstance> objects;
 
+// Triangle BVH of each placed mesh, built the first time the mesh is placed
+std::map<const Mesh*, MeshBvh> meshBvhs;
+
+// Object bounds in a dynamic tree, so collision checks and culling only visit nearby or
+// visible objects while crates are spawned, moved and removed
+DynamicAabbTree objectTree;
+std::vector<int> objectProxies;     // tree proxy of objects[i]
+AabbBatch objectBoxes;              // bounds of objects[i].worldBox, precomputed
+std::vector<int> collisionCandidates;
+std::vector<uint32_t> collisionMasks;
+std::vector<int> nearbyObjects;
+std::vector<int> visibleObjects;
+
+// Model matrices of the visible objects grouped by mesh, refilled every frame; each
+// group is drawn with one instanced call
+std::map<Mesh*, std::vector<glm::mat4>> instanceModels;
+int objectDrawCalls = 0;
+
+// Crates spawned during play (C places one ahead, X removes the latest)
+int   spawnedCrates = 0;
+bool  cKeyWasPressed = false;
+bool  xKeyWasPressed = false;
+
 // HUD shader + quad
 Shader* hudShader = nullptr;
 Mesh* hudQuad = nullptr;
+GLint hudMvpUniform = -1;
+GLint hudColorUniform = -1;
+
+// Buffers behind the FrameUniforms and SceneUniforms blocks every program shares
+UniformBuffer* frameUniforms = nullptr;
+UniformBuffer* sceneUniforms = nullptr;
+
+// Hazard zones and their tile grid for the fragment shader, and the GameState hazard
+// revision they were last uploaded from
+HazardTextures* hazardTextures = nullptr;
+int hazardTexturesRevision = -1;
+
+// Pit darkening baked over the terrain (windowed game only), and the texels re-baked
+// since it was last uploaded
+HazardMask hazardMask;
+TerrainRegion hazardMaskDirty = { 0, 0, -1, -1 };
+
+// Terrain renderers and the CPU grid the quadtree one is built from
+TerrainGrid terrainGrid;
+TerrainLOD* terrainLOD = nullptr;
+TerrainClipmap* terrainClipmap = nullptr;
+TerrainHeightPyramid* terrainPyramid = nullptr;    // ray casts against terrainGrid
+
+// Terrain re-carved by simulation steps since the last rendered frame, uploaded by
+// uploadTerrainEdits: grid vertices for TerrainLOD, a world rectangle for the clipmap
+TerrainRegion terrainDirty = { 0, 0, -1, -1 };
+bool clipmapDirty = false;
+glm::vec2 clipmapDirtyMin, clipmapDirtyMax;
+
+// Pits dropped during play (P places one ahead, O removes the latest)
+std::vector<HazardZone> droppedPits;
+bool  pKeyWasPressed = false;
+bool  oKeyWasPressed = false;
 
 // Mouse sensitivity presets
 float sensitivities[] = { 0.05f, 0.02f, 0.01f };
@@ -84,220 +219,495 @@ bool  mKeyWasPressed = false;
 
 // ---------- COLLISION HELPERS FOR BOXES ----------
 
-float sampleTerrainBaseHeight(float x, float z)
+// Oriented box around the drawn mesh: its local bounds under the object's model matrix
+Obb computeObjectBox(const ObjectInstance& obj)
 {
-    float height =
-        0.5f * sin(x * 0.05f) * cos(z * 0.05f)
-        + 0.3f * sin(x * 0.15f) * cos(z * 0.15f)
-        + 0.2f * sin(x * 0.3f) * cos(z * 0.3f);
-    return height;
+    Aabb localBounds = { obj.mesh->boundsMin, obj.mesh->boundsMax };
+    return Obb::fromTransform(localBounds, obj.position, obj.scale, obj.rotationY);
 }
 
+glm::mat4 computeObjectModel(const ObjectInstance& obj)
+{
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), obj.position);
+    // glm 0.9.4 takes degrees here, the unit Obb::fromTransform uses for rotationY
+    model = glm::rotate(model, obj.rotationY, glm::vec3(0, 1, 0));
+    return glm::scale(model, obj.scale);
+}
 
-bool checkCollision3D(const glm::vec3& playerPos,
-    const glm::vec3& objectPos,
-    const glm::vec3& objectScale)
+MeshTransform getObjectTransform(const ObjectInstance& obj)
 {
-    float playerHalfWidth = PLAYER_RADIUS;
-    float playerHalfDepth = PLAYER_RADIUS;
-    float playerHalfHeight = PLAYER_HEIGHT * 0.5f;
-
-    float pMinX = playerPos.x - playerHalfWidth;
-    float pMaxX = playerPos.x + playerHalfWidth;
-    float pMinY = playerPos.y - playerHalfHeight;
-    float pMaxY = playerPos.y + playerHalfHeight;
-    float pMinZ = playerPos.z - playerHalfDepth;
-    float pMaxZ = playerPos.z + playerHalfDepth;
-
-    float oHalfX = objectScale.x;
-    float oHalfY = objectScale.y;
-    float oHalfZ = objectScale.z;
-
-    float oMinX = objectPos.x - oHalfX;
-    float oMaxX = objectPos.x + oHalfX;
-    float oMinY = objectPos.y - oHalfY;
-    float oMaxY = objectPos.y + oHalfY;
-    float oMinZ = objectPos.z - oHalfZ;
-    float oMaxZ = objectPos.z + oHalfZ;
-
-    bool overlapX = (pMinX <= oMaxX) && (pMaxX >= oMinX);
-    bool overlapY = (pMinY <= oMaxY) && (pMaxY >= oMinY);
-    bool overlapZ = (pMinZ <= oMaxZ) && (pMaxZ >= oMinZ);
-
-    return overlapX && overlapY && overlapZ;
+    MeshTransform transform = { obj.position, obj.scale, obj.rotationY };
+    return transform;
 }
 
-bool checkCollisionAllowJump(const glm::vec3& playerPos,
-    const glm::vec3& objectPos,
-    const glm::vec3& objectScale)
+void addObject(ObjectInstance obj)
 {
-    float playerHalfHeight = PLAYER_HEIGHT * 0.5f;
-    float playerFeetY = playerPos.y - playerHalfHeight;
+    auto bvh = meshBvhs.find(obj.mesh);
+    if (bvh == meshBvhs.end())
+        bvh = meshBvhs.insert(std::make_pair(obj.mesh, MeshBvh(*obj.mesh))).first;
+    obj.collisionMesh = &bvh->second;
+
+    obj.worldBox = computeObjectBox(obj);
+    obj.model = computeObjectModel(obj);
+    Aabb bounds = obj.worldBox.getBounds();
+
+    objects.push_back(obj);
+    objectProxies.push_back(objectTree.createProxy(bounds, static_cast<int>(objects.size()) - 1));
+    objectBoxes.add(bounds);
+}
 
-    float objectTopY = objectPos.y + objectScale.y;
+// World boxes are cached, so static objects cost nothing per frame; call this after
+// changing an object's position, scale or rotation
+void updateObjectBounds(int index)
+{
+    ObjectInstance& obj = objects[index];
+    glm::vec3 oldCenter = obj.worldBox.center;
 
-    if (playerFeetY > objectTopY)
-        return false;
+    obj.worldBox = computeObjectBox(obj);
+    obj.model = computeObjectModel(obj);
+    Aabb bounds = obj.worldBox.getBounds();
 
-    return checkCollision3D(playerPos, objectPos, objectScale);
+    objectTree.moveProxy(objectProxies[index], bounds, obj.worldBox.center - oldCenter);
+    objectBoxes.set(index, bounds);
 }
 
-bool checkAllCollisions(const glm::vec3& newPosition,
-    const std::vector<ObjectInstance>& objects)
+void removeLastObject()
 {
-    for (const auto& obj : objects) {
-        if (checkCollisionAllowJump(newPosition, obj.position, obj.scale))
-            return true;
-    }
-    return false;
+    objectTree.destroyProxy(objectProxies.back());
+    objectProxies.pop_back();
+    objectBoxes.removeLast();
+    objects.pop_back();
 }
 
-// ---------- PIT DETECTION ----------
+// Player box around the camera; its bottom is the player's feet, so a player whose feet
+// are above a crate's top face does not collide with it (jumping over crates)
+Aabb getPlayerBox(const glm::vec3& cameraPos)
+{
+    return Aabb::fromCenter(cameraPos, glm::vec3(PLAYER_RADIUS, PLAYER_HEIGHT * 0.5f, PLAYER_RADIUS));
+}
 
-bool isInsidePit(const glm::vec3& playerPos, const HazardZone& pit)
+// Nearest object triangle hit by the ray within maxDistance
+MeshRayHit raycastObjects(const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
 {
-    float halfX = pit.size.x * 0.5f;
-    float halfZ = pit.size.z * 0.5f;
+    MeshRayHit nearest;
+    nearest.hit = false;
+    nearest.distance = maxDistance;
+
+    collisionCandidates.clear();
+    objectTree.raycast(origin, direction, maxDistance, collisionCandidates);
+    for (int id : collisionCandidates) {
+        const ObjectInstance& obj = objects[id];
+        MeshRayHit hit = obj.collisionMesh->raycast(getObjectTransform(obj), origin, direction, nearest.distance);
+        if (hit.hit)
+            nearest = hit;
+    }
+    return nearest;
+}
 
-    float minX = pit.position.x - halfX;
-    float maxX = pit.position.x + halfX;
-    float minZ = pit.position.z - halfZ;
-    float maxZ = pit.position.z + halfZ;
+// Moves the player by this frame's displacement, sliding along the triangles of the
+// objects in the way. One broadphase query covers the whole move: moveAndSlide clamps the
+// player's horizontal travel, pushes included, to the move's length plus a skin, and its
+// contact queries reach one more skin past the capsule, so the player box grown by both
+// holds every object it can touch. Each contact query first rejects objects whose oriented
+// box is separated from the query capsule's box; contacts come from the triangles of the rest.
+void movePlayer(const glm::vec3& displacement)
+{
+    glm::vec3 position = camera.getCameraPosition();
+    Aabb playerBox = getPlayerBox(position);
+    float reach = glm::length(displacement) + 2.0f * MOVE_AND_SLIDE_SKIN;
+    Aabb sweptBox = { playerBox.min - glm::vec3(reach), playerBox.max + glm::vec3(reach) };
+
+    collisionCandidates.clear();
+    objectTree.query(sweptBox, collisionCandidates);
+
+    nearbyObjects.clear();
+    if (!collisionCandidates.empty()) {
+        int candidateCount = static_cast<int>(collisionCandidates.size());
+        collisionMasks.resize(AabbBatch::getMaskWordCount(candidateCount));
+        objectBoxes.overlapMask(sweptBox, collisionCandidates.data(), candidateCount, collisionMasks.data());
+
+        for (int k = 0; k < candidateCount; ++k) {
+            if (collisionMasks[k / 32] & (1u << (k % 32)))
+                nearbyObjects.push_back(collisionCandidates[k]);
+        }
+    }
 
-    bool insideXZ = (playerPos.x >= minX && playerPos.x <= maxX &&
-        playerPos.z >= minZ && playerPos.z <= maxZ);
+    auto closestContact = [](const glm::vec3& a, const glm::vec3& b, float radius) {
+        MeshContact closest;
+        closest.hit = false;
+        closest.distance = radius;
+        Aabb capsuleBox = { glm::min(a, b) - glm::vec3(radius), glm::max(a, b) + glm::vec3(radius) };
+        for (int id : nearbyObjects) {
+            const ObjectInstance& obj = objects[id];
+            if (!obj.worldBox.overlaps(capsuleBox))
+                continue;
+            MeshContact contact = obj.collisionMesh->capsuleContact(getObjectTransform(obj), a, b, closest.distance);
+            if (contact.hit)
+                closest = contact;
+        }
+        return closest;
+    };
 
-    return insideXZ;
+    // The capsule spans the player box: its bottom is the player's feet, so a player whose
+    // feet are above a crate's top does not touch it (jumping over crates)
+    float halfAxis = PLAYER_HEIGHT * 0.5f - PLAYER_RADIUS;
+    camera.setCameraPosition(position + moveAndSlide(position, halfAxis, PLAYER_RADIUS, displacement, closestContact));
 }
 
-bool checkAnyPitFall(const glm::vec3& playerPos, const std::vector<HazardZone>& pits)
+// ---------- RUNTIME HAZARDS ----------
+
+// Re-carves only the terrain, and re-bakes only the hazard mask, under a pit that was
+// just added or removed. Runs inside simulation steps, so it only changes the CPU copies
+// and records what the GPU still needs (see uploadTerrainEdits and updateSceneUniforms).
+void refreshTerrainUnderPit(const HazardZone& pit)
 {
-    for (const auto& pit : pits) {
-        if (isInsidePit(playerPos, pit))
-            return true;
+    if (!hazardMask.texels.empty()) {
+        TerrainRegion dirty = rebakeHazardMaskRegion(hazardMask, getHazardMaskRegion(hazardMask, pit), gameState.getHazardZones());
+        hazardMaskDirty = mergeRegions(hazardMaskDirty, dirty);
+    }
+
+    if (terrainPyramid) {
+        TerrainRegion region = getPitRegion(terrainGrid, pit);
+        TerrainRegion dirty = recarveTerrainRegion(terrainGrid, region, gameState.getHazardZones());
+        terrainPyramid->updateRegion(dirty);
+        terrainDirty = mergeRegions(terrainDirty, dirty);
+    }
+    else {
+        float radius = pit.size.x / 2.0f;
+        glm::vec2 center(pit.position.x, pit.position.z);
+        clipmapDirtyMin = clipmapDirty ? glm::min(clipmapDirtyMin, center - radius) : center - radius;
+        clipmapDirtyMax = clipmapDirty ? glm::max(clipmapDirtyMax, center + radius) : center + radius;
+        clipmapDirty = true;
     }
-    return false;
 }
 
-// ---------- MOUSE + SCROLL CALLBACKS ----------
+// Sends the terrain re-carved since the last frame to the GPU, once per rendered frame
+void uploadTerrainEdits()
+{
+    if (terrainLOD)
+        terrainLOD->updateRegion(terrainGrid, terrainDirty);
+    terrainDirty = { 0, 0, -1, -1 };
 
-void mouse_callback(GLFWwindow* glfwWin, double xpos, double ypos)
+    if (terrainClipmap && clipmapDirty)
+        terrainClipmap->refreshRect(clipmapDirtyMin.x, clipmapDirtyMin.y, clipmapDirtyMax.x, clipmapDirtyMax.y);
+    clipmapDirty = false;
+}
+
+void processHazardEditInput()
 {
-    if (firstMouse) {
-        lastX = static_cast<float>(xpos);
-        lastY = static_cast<float>(ypos);
-        firstMouse = false;
+    bool pKey = input.isPressed(GLFW_KEY_P);
+    if (pKey && !pKeyWasPressed) {
+        glm::vec3 ahead = camera.getCameraViewDirection();
+        ahead.y = 0.0f;
+        if (glm::length(ahead) < 0.001f)
+            ahead = glm::vec3(0.0f, 0.0f, -1.0f);
+
+        HazardZone pit;
+        pit.position = camera.getCameraPosition() + glm::normalize(ahead) * 40.0f;
+
+        // Drop it where the crosshair meets the ground when that is in reach, or below
+        // the first object in the way
+        TerrainRay ray = { camera.getCameraPosition(), glm::normalize(camera.getCameraViewDirection()), 300.0f };
+        if (terrainPyramid) {
+            TerrainHit hit = terrainPyramid->raycast(ray);
+            if (hit.hit) {
+                pit.position = hit.position;
+                ray.maxDistance = hit.distance;
+            }
+        }
+        MeshRayHit objectHit = raycastObjects(ray.origin, ray.direction, ray.maxDistance);
+        if (objectHit.hit)
+            pit.position = objectHit.position;
+        pit.position.y = 0.0f;
+        pit.size = glm::vec3(20.0f, 10.0f, 20.0f);
+        pit.damage = 1;
+        pit.name = "Dropped Pit " + std::to_string(droppedPits.size() + 1);
+
+        gameState.addHazardZone(pit.position, pit.size, pit.damage, pit.name);
+        droppedPits.push_back(pit);
+        refreshTerrainUnderPit(pit);
+
+        if (logSimulationEvents)
+            std::cout << "Added " << pit.name << " at (" << pit.position.x << ", " << pit.position.z << ")" << std::endl;
     }
+    pKeyWasPressed = pKey;
 
-    float xoffset = static_cast<float>(xpos) - lastX;
-    float yoffset = lastY - static_cast<float>(ypos);
-    lastX = static_cast<float>(xpos);
-    lastY = static_cast<float>(ypos);
+    bool oKey = input.isPressed(GLFW_KEY_O);
+    if (oKey && !oKeyWasPressed && !droppedPits.empty()) {
+        HazardZone pit = droppedPits.back();
+        droppedPits.pop_back();
 
-    float sensitivity = sensitivities[currentSensitivityIndex];
-    xoffset *= sensitivity;
-    yoffset *= sensitivity;
+        gameState.removeHazardZone(pit.name);
+        refreshTerrainUnderPit(pit);
 
-    camera.rotateOy(glm::radians(-xoffset));  // yaw
-    camera.rotateOx(glm::radians(yoffset));  // pitch
+        if (logSimulationEvents)
+            std::cout << "Removed " << pit.name << std::endl;
+    }
+    oKeyWasPressed = oKey;
 }
 
-void scroll_callback(GLFWwindow* windowPtr, double xoffset, double yoffset)
+// ---------- RUNTIME OBJECTS ----------
+
+void processObjectEditInput()
 {
-    fov -= static_cast<float>(yoffset) * 2.0f;
-    if (fov < 60.0f)  fov = 60.0f;
-    if (fov > 120.0f) fov = 120.0f;
+    bool cKey = input.isPressed(GLFW_KEY_C);
+    if (cKey && !cKeyWasPressed && !objects.empty()) {
+        glm::vec3 ahead = camera.getCameraViewDirection();
+        ahead.y = 0.0f;
+        if (glm::length(ahead) < 0.001f)
+            ahead = glm::vec3(0.0f, 0.0f, -1.0f);
+
+        ObjectInstance crate = objects[spawnedCrates % objects.size()];
+        crate.position = camera.getCameraPosition() + glm::normalize(ahead) * 30.0f;
+        crate.position.y = 0.0f;
+        crate.rotationY = static_cast<float>((spawnedCrates * 37) % 360);
+
+        addObject(crate);
+        spawnedCrates++;
+
+        if (logSimulationEvents)
+            std::cout << "Spawned crate at (" << crate.position.x << ", " << crate.position.z << "), "
+            << objects.size() << " objects" << std::endl;
+    }
+    cKeyWasPressed = cKey;
+
+    bool xKey = input.isPressed(GLFW_KEY_X);
+    if (xKey && !xKeyWasPressed && spawnedCrates > 0) {
+        removeLastObject();
+        spawnedCrates--;
+
+        if (logSimulationEvents)
+            std::cout << "Removed crate, " << objects.size() << " objects" << std::endl;
+    }
+    xKeyWasPressed = xKey;
 }
 
-// ---------- TERRAIN GENERATION ----------
+// ---------- SIMULATION ----------
 
-Mesh createTerrainMesh(float size, int divisions, GLuint textureID, const std::vector<HazardZone>& pits)
+// Advances input, movement, jumping and pits by one SIM_TIMESTEP. No GL calls: terrain
+// and hazard mask edits are recorded and uploaded by the render loop, so a step can run
+// any number of times per rendered frame, or with no GL context at all.
+void simulationStep()
 {
-    std::vector<Vertex>  vertices;
-    std::vector<int>     indices;
-    std::vector<Texture> texVec;
-
-    for (int z = 0; z <= divisions; ++z) {
-        for (int x = 0; x <= divisions; ++x) {
-            float fx = -size + 2.0f * size * (float)x / (float)divisions;
-            float fz = -size + 2.0f * size * (float)z / (float)divisions;
-
-            Vertex v;
-
-            float height = 0.5f * sin(fx * 0.05f) * cos(fz * 0.05f)
-                + 0.3f * sin(fx * 0.15f) * cos(fz * 0.15f)
-                + 0.2f * sin(fx * 0.3f) * cos(fz * 0.3f);
-
-            for (const auto& pit : pits) {
-                float dx = fx - pit.position.x;
-                float dz = fz - pit.position.z;
-                float distance = sqrt(dx * dx + dz * dz);
-                float pitRadius = pit.size.x / 2.0f;
-
-                if (distance < pitRadius) {
-                    float normalizedDist = distance / pitRadius;
-                    float falloff = 1.0f - normalizedDist;
-                    falloff = falloff * falloff;
-                    float pitDepth = 4.0f;
-                    height -= pitDepth * falloff;
-                }
+    if (!isFallingInPit) {
+        processKeyboardInput();
+        processHazardEditInput();
+        processObjectEditInput();
+
+        glm::vec3 pos = camera.getCameraPosition();
+
+        if (input.isPressed(GLFW_KEY_SPACE) && isGrounded && !isCrouching) {
+            verticalVelocity = JUMP_SPEED;
+            isGrounded = false;
+        }
+
+        if (!isGrounded) {
+            verticalVelocity += GRAVITY * SIM_TIMESTEP;
+            pos.y += verticalVelocity * SIM_TIMESTEP;
+
+            float currentGroundY = isCrouching ? CROUCH_HEIGHT : STAND_HEIGHT;
+            if (pos.y <= currentGroundY) {
+                pos.y = currentGroundY;
+                verticalVelocity = 0.0f;
+                isGrounded = true;
             }
+        }
+        else {
+            float currentGroundY = isCrouching ? CROUCH_HEIGHT : STAND_HEIGHT;
+            pos.y = currentGroundY;
+            verticalVelocity = 0.0f;
+        }
 
-            v.pos = glm::vec3(fx, height, fz);
-            v.textureCoords = glm::vec2(
-                (float)x / (float)divisions * 10.0f,
-                (float)z / (float)divisions * 10.0f
-            );
+        camera.setCameraPosition(pos);
+
+        // Same disc the terrain is carved with, so falling starts where the ground drops
+        if (gameState.findHazardZone(camera.getCameraPosition()) >= 0) {
+            isFallingInPit = true;
+            fallStartTick = simTick;
+            verticalVelocity = -40.0f;
+            if (logSimulationEvents)
+                std::cout << "You fell into a pit! Lives left after this: " << (lives - 1) << std::endl;
+        }
 
-            vertices.push_back(v);
+    }
+    else {
+        glm::vec3 pos = camera.getCameraPosition();
+        verticalVelocity += GRAVITY * SIM_TIMESTEP;
+        pos.y += verticalVelocity * SIM_TIMESTEP;
+        camera.setCameraPosition(pos);
+
+        if ((simTick - fallStartTick) * SIM_TIMESTEP >= fallDuration) {
+            lives--;
+            isFallingInPit = false;
+            verticalVelocity = 0.0f;
+            isGrounded = true;
+            isCrouching = false;
+            camera.setCameraPosition(respawnPoint);
+            previousSimPosition = respawnPoint;     // no blending across the teleport
+            if (logSimulationEvents)
+                std::cout << "Respawned at start. Lives: " << lives << "/" << maxLives << std::endl;
         }
     }
 
-    for (int z = 0; z <= divisions; ++z) {
-        for (int x = 0; x <= divisions; ++x) {
-            int idx = z * (divisions + 1) + x;
+    simTick++;
+}
+
+// Applies one frame of player input, then runs the fixed steps its time covers.
+// Returns the number of steps run.
+int advanceFrame(const InputFrame& frame)
+{
+    input = frame;
 
-            glm::vec3 pos = vertices[idx].pos;
+    if (frame.mouseDeltaX != 0.0f || frame.mouseDeltaY != 0.0f) {
+        float sensitivity = sensitivities[currentSensitivityIndex];
+        camera.rotateOy(glm::radians(-frame.mouseDeltaX * sensitivity));  // yaw
+        camera.rotateOx(glm::radians(frame.mouseDeltaY * sensitivity));   // pitch
+    }
 
-            glm::vec3 posLeft = (x > 0) ? vertices[idx - 1].pos : pos;
-            glm::vec3 posRight = (x < divisions) ? vertices[idx + 1].pos : pos;
-            glm::vec3 posDown = (z > 0) ? vertices[idx - (divisions + 1)].pos : pos;
-            glm::vec3 posUp = (z < divisions) ? vertices[idx + (divisions + 1)].pos : pos;
+    fov -= frame.scroll * 2.0f;
+    if (fov < 60.0f)  fov = 60.0f;
+    if (fov > 120.0f) fov = 120.0f;
 
-            glm::vec3 tangentX = glm::normalize(posRight - posLeft);
-            glm::vec3 tangentZ = glm::normalize(posUp - posDown);
+    simAccumulator += std::min(frame.frameTime, MAX_FRAME_TIME);
 
-            glm::vec3 normal = glm::normalize(glm::cross(tangentZ, tangentX));
-            vertices[idx].normals = normal;
-        }
+    int steps = 0;
+    while (simAccumulator >= SIM_TIMESTEP && lives > 0) {
+        previousSimPosition = camera.getCameraPosition();
+        simulationStep();
+        simAccumulator -= SIM_TIMESTEP;
+        steps++;
     }
+    return steps;
+}
 
-    for (int z = 0; z < divisions; ++z) {
-        for (int x = 0; x < divisions; ++x) {
-            int row1 = z * (divisions + 1);
-            int row2 = (z + 1) * (divisions + 1);
+// Puts the player back at the start, standing still
+void resetPlayer()
+{
+    camera.setCameraPosition(respawnPoint);
+    isGrounded = true;
+    isCrouching = false;
+    isFallingInPit = false;
+    verticalVelocity = 0.0f;
+    previousSimPosition = respawnPoint;
+}
 
-            int i0 = row1 + x;
-            int i1 = row1 + x + 1;
-            int i2 = row2 + x;
-            int i3 = row2 + x + 1;
+// Hash of everything the simulation carries from one step to the next. Two replays of
+// the same log end with the same checksum unless the simulation's behavior changed.
+uint64_t computeStateChecksum()
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    glm::vec3 position = camera.getCameraPosition();
+    glm::vec3 view = camera.getCameraViewDirection();
+    hashBytes(hash, &position[0], sizeof(float) * 3);
+    hashBytes(hash, &view[0], sizeof(float) * 3);
+    hashBytes(hash, &verticalVelocity, sizeof(verticalVelocity));
+    hashBytes(hash, &simTick, sizeof(simTick));
+
+    int flags[] = { isGrounded, isCrouching, isFallingInPit, lives, currentSensitivityIndex };
+    hashBytes(hash, flags, sizeof(flags));
+
+    for (const ObjectInstance& obj : objects) {
+        hashBytes(hash, &obj.position[0], sizeof(float) * 3);
+        hashBytes(hash, &obj.scale[0], sizeof(float) * 3);
+        hashBytes(hash, &obj.rotationY, sizeof(obj.rotationY));
+    }
+    for (const HazardZone& zone : gameState.getHazardZones()) {
+        hashBytes(hash, &zone.position[0], sizeof(float) * 3);
+        hashBytes(hash, &zone.size[0], sizeof(float) * 3);
+    }
+    return hash;
+}
 
-            indices.push_back(i0);
-            indices.push_back(i2);
-            indices.push_back(i1);
+// Prints the spread of per-frame times, in milliseconds
+void reportFrameTimes(std::vector<double>& frameTimes)
+{
+    if (frameTimes.empty())
+        return;
 
-            indices.push_back(i1);
-            indices.push_back(i2);
-            indices.push_back(i3);
-        }
+    double total = 0.0;
+    for (double t : frameTimes)
+        total += t;
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+    size_t last = frameTimes.size() - 1;
+    std::cout << "Frame times (ms): avg " << total / frameTimes.size()
+        << " p50 " << frameTimes[last / 2]
+        << " p95 " << frameTimes[last * 95 / 100]
+        << " p99 " << frameTimes[last * 99 / 100]
+        << " max " << frameTimes[last] << std::endl;
+}
+
+// Loads a recorded session for replay, warning when it was recorded with another step
+bool loadReplay(const std::string& path, InputLog& log)
+{
+    if (!log.load(path))
+        return false;
+
+    std::cout << "Replaying " << log.getFrameCount() << " frames from " << path << std::endl;
+    if (log.getSimTimestep() != SIM_TIMESTEP)
+        std::cout << "Warning: recorded with a " << log.getSimTimestep() << " s step, this build uses "
+            << SIM_TIMESTEP << " s" << std::endl;
+    return true;
+}
+
+// ---------- MOUSE + SCROLL CALLBACKS ----------
+
+void mouse_callback(GLFWwindow* glfwWin, double xpos, double ypos)
+{
+    if (firstMouse) {
+        lastX = static_cast<float>(xpos);
+        lastY = static_cast<float>(ypos);
+        firstMouse = false;
     }
 
-    texVec.push_back(Texture());
-    texVec[0].id = textureID;
-    texVec[0].type = "texture_diffuse";
+    // Turning waits for the next frame's input, so the simulation sees it in order
+    pendingMouseX += static_cast<float>(xpos) - lastX;
+    pendingMouseY += lastY - static_cast<float>(ypos);
+    lastX = static_cast<float>(xpos);
+    lastY = static_cast<float>(ypos);
+}
+
+void scroll_callback(GLFWwindow* windowPtr, double xoffset, double yoffset)
+{
+    pendingScroll += static_cast<float>(yoffset);
+}
+
+// ---------- SCENE UNIFORMS ----------
+
+// Camera and light for every program, written once per frame
+void updateFrameUniforms(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& eyePosition)
+{
+    FrameUniformData data;
+    data.view = view;
+    data.projection = projection;
+    data.viewProjection = projection * view;
+    data.cameraPosition = glm::vec4(eyePosition, 1.0f);
+    data.lightPosition = glm::vec4(lightPos, 1.0f);
+    data.lightColor = glm::vec4(lightColor, 1.0f);
+    frameUniforms->update(&data);
+}
+
+// Hazard zones darkening the ground; the textures and the block are only rewritten on
+// frames where the zones changed
+void updateSceneUniforms()
+{
+    if (hazardTexturesRevision == gameState.getHazardRevision())
+        return;
+
+    const HazardIndex& index = gameState.getHazardIndex();
+    hazardTextures->update(gameState.getHazardZones(), index);
+    hazardTextures->updateMaskRegion(hazardMask, hazardMaskDirty);
+    hazardMaskDirty = { 0, 0, -1, -1 };
+
+    SceneUniformData data;
+    data.hazardGrid = glm::vec4(index.getOrigin(), 1.0f / index.getCellSize(), 0.0f);
+    data.hazardGridSize = glm::ivec4(index.getCellsX(), index.getCellsZ(), 0, 0);
+    data.hazardMaskArea = hazardMask.texels.empty() ? glm::vec4(0.0f)
+        : glm::vec4(-hazardMask.size, -hazardMask.size, 1.0f / (2.0f * hazardMask.size), 1.0f);
+    sceneUniforms->update(&data);
 
-    Mesh terrainMesh(vertices, indices, texVec);
-    return terrainMesh;
+    hazardTexturesRevision = gameState.getHazardRevision();
 }
 
 // ---------- HEART HUD RENDERING ----------
@@ -311,17 +721,14 @@ void drawHeartsHUD(int livesLeft)
     hudShader->use();
 
     glm::mat4 ortho = glm::ortho(
-        0.0f, static_cast<float>(window.getWidth()),
-        0.0f, static_cast<float>(window.getHeight())
+        0.0f, static_cast<float>(window->getWidth()),
+        0.0f, static_cast<float>(window->getHeight())
     );
 
-    GLuint mvpLoc = glGetUniformLocation(hudShader->getId(), "MVP");
-    GLuint colorLoc = glGetUniformLocation(hudShader->getId(), "color");
-
     float heartSize = 80.0f;
     float padding = 20.0f;
-    float startX = static_cast<float>(window.getWidth()) - padding - heartSize;
-    float y = static_cast<float>(window.getHeight()) - padding - heartSize;
+    float startX = static_cast<float>(window->getWidth()) - padding - heartSize;
+    float y = static_cast<float>(window->getHeight()) - padding - heartSize;
 
     for (int i = 0; i < maxLives; ++i) {
         float x = startX - i * (heartSize + 15.0f);
@@ -336,8 +743,8 @@ void drawHeartsHUD(int livesLeft)
             ? glm::vec3(1.0f, 0.0f, 0.0f)
             : glm::vec3(0.3f, 0.0f, 0.0f);
 
-        glUniformMatrix4fv(mvpLoc, 1, GL_FALSE, &mvp[0][0]);
-        glUniform3f(colorLoc, color.r, color.g, color.b);
+        hudShader->setMat4(hudMvpUniform, mvp);
+        hudShader->setVec3(hudColorUniform, color);
 
         hudQuad->draw(*hudShader);
     }
@@ -345,22 +752,227 @@ void drawHeartsHUD(int livesLeft)
     glEnable(GL_DEPTH_TEST);
 }
 
+// ---------- LEVEL ----------
+
+// Crates and pits of the level; staticMeshes holds the CRATE_MODELS in order and must
+// not grow afterwards, objects point into it
+void buildLevel(std::vector<Mesh>& staticMeshes)
+{
+    addObject({ &staticMeshes[0], glm::vec3(-80, 0, -80),   glm::vec3(7.5, 7.5, 7.5), 0 });
+    addObject({ &staticMeshes[1], glm::vec3(-100, 0, -60),  glm::vec3(7.5, 7.5, 7.5), 30 });
+    addObject({ &staticMeshes[2], glm::vec3(-120, 0, -70),  glm::vec3(7.5, 7.5, 7.5), 60 });
+    addObject({ &staticMeshes[3], glm::vec3(150, 0, 120),   glm::vec3(9.0, 9.0, 9.0), 90 });
+    addObject({ &staticMeshes[4], glm::vec3(170, 0, 140),   glm::vec3(10.0, 10.0, 10.0), 120 });
+    addObject({ &staticMeshes[0], glm::vec3(-200, 0, 100),  glm::vec3(6.0, 6.0, 6.0), 150 });
+    addObject({ &staticMeshes[2], glm::vec3(250, 0, -150),  glm::vec3(8.0, 8.0, 8.0), 180 });
+    addObject({ &staticMeshes[1], glm::vec3(50, 0, 200),    glm::vec3(7.0, 7.0, 7.0), 210 });
+    addObject({ &staticMeshes[3], glm::vec3(-300, 0, -50),  glm::vec3(8.5, 8.5, 8.5), 240 });
+    addObject({ &staticMeshes[4], glm::vec3(300, 0, -200),  glm::vec3(11.0, 11.0, 11.0), 270 });
+
+    gameState.addHazardZone(glm::vec3(0, 0, 700), glm::vec3(20, 10, 20), 1, "Test Pit (ahead)");
+    gameState.addHazardZone(glm::vec3(50, 0, 50), glm::vec3(18, 10, 18), 1, "Radiation Pit Alpha");
+    gameState.addHazardZone(glm::vec3(-150, 0, -100), glm::vec3(22, 10, 22), 1, "Toxic Pit Beta");
+    gameState.addHazardZone(glm::vec3(200, 0, 150), glm::vec3(20, 10, 20), 1, "Crater Gamma");
+    gameState.addHazardZone(glm::vec3(-250, 0, 200), glm::vec3(25, 10, 25), 1, "Deep Pit Delta");
+    gameState.addHazardZone(glm::vec3(180, 0, -120), glm::vec3(15, 10, 15), 1, "Small Pit Epsilon");
+    gameState.addHazardZone(glm::vec3(-80, 0, 250), glm::vec3(18, 10, 18), 1, "Hazard Pit Zeta");
+    gameState.addHazardZone(glm::vec3(300, 0, 50), glm::vec3(23, 10, 23), 1, "Alien Crater Eta");
+    gameState.addHazardZone(glm::vec3(-200, 0, -200), glm::vec3(17, 10, 17), 1, "Dark Pit Theta");
+    gameState.addHazardZone(glm::vec3(100, 0, 300), glm::vec3(20, 10, 20), 1, "Danger Zone Iota");
+}
+
+// Extra crates spread over the map to measure object rendering (--props <count>), each
+// one of the CRATE_MODELS at random and standing on the carved terrain under it.
+// The same count always gives the same layout; the spawn area is kept clear.
+void scatterProps(std::vector<Mesh>& staticMeshes, int count)
+{
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> coord(-TERRAIN_SIZE * 0.95f, TERRAIN_SIZE * 0.95f);
+    std::uniform_real_distribution<float> scale(4.0f, 10.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+    std::uniform_int_distribution<int> mesh(0, static_cast<int>(staticMeshes.size()) - 1);
+
+    for (int placed = 0; placed < count;) {
+        float x = coord(rng);
+        float z = coord(rng);
+        float size = scale(rng);
+        float rotation = angle(rng);
+        Mesh* propMesh = &staticMeshes[mesh(rng)];
+        if (glm::length(glm::vec2(x - respawnPoint.x, z - respawnPoint.z)) < 40.0f)
+            continue;
+
+        glm::vec3 position(x, carvePits(x, z, sampleTerrainBaseHeight(x, z), gameState.getHazardZones()), z);
+        addObject({ propMesh, position, glm::vec3(size), rotation });
+        placed++;
+    }
+}
+
+// ---------- HEADLESS RUN ----------
+
+// Scripted player for headless runs: walks forward while turning, jumps, crouches and
+// strafes now and then, and drops and removes crates and pits. Input depends only on
+// the tick and the player's position, so runs can be compared across builds.
+InputFrame scriptedInput(int tick)
+{
+    InputFrame frame;
+    frame.frameTime = SIM_TIMESTEP;
+
+    // A new turn rate, -300 to 300 pixels a tick, every 90 ticks; near the edge of the
+    // terrain it turns back toward the middle instead
+    uint32_t segment = static_cast<uint32_t>(tick / 90) * 2654435761u;
+    frame.mouseDeltaX = static_cast<float>(static_cast<int>((segment >> 16) % 601) - 300);
+
+    glm::vec3 pos = camera.getCameraPosition();
+    float edge = TERRAIN_SIZE * 0.45f;
+    if (pos.x * pos.x + pos.z * pos.z > edge * edge) {
+        glm::vec3 view = camera.getCameraViewDirection();
+        float toMiddleSide = view.x * pos.z - view.z * pos.x;    // (view x -pos).y
+        frame.mouseDeltaX = toMiddleSide > 0.0f ? -300.0f : 300.0f;
+    }
+
+    int strafe = tick % 1200;
+    frame.setPressed(GLFW_KEY_W, strafe >= 240);
+    frame.setPressed(GLFW_KEY_A, strafe < 120);
+    frame.setPressed(GLFW_KEY_D, strafe >= 120 && strafe < 240);
+    frame.setPressed(GLFW_KEY_SPACE, tick % 150 < 2);
+    frame.setPressed(GLFW_KEY_LEFT_CONTROL, tick % 1000 >= 500 && tick % 1000 < 560);
+
+    frame.setPressed(GLFW_KEY_C, tick % 2000 == 100);
+    frame.setPressed(GLFW_KEY_X, tick % 2000 == 1100);
+    frame.setPressed(GLFW_KEY_P, tick % 3000 == 700);
+    frame.setPressed(GLFW_KEY_O, tick % 3000 == 2200);
+    return frame;
+}
+
+// Runs the level with no window and no GL context, then reports the simulation rate.
+// Without a replay the scripted player plays for the given number of ticks, with lives
+// refilled when they run out; a replay plays every recorded frame, or until game over.
+int runHeadless(int ticks, const InputLog* replay)
+{
+    if (replay)
+        std::cout << "=== Headless replay: " << replay->getFrameCount() << " frames ===" << std::endl;
+    else
+        std::cout << "=== Headless run: " << ticks << " ticks ===" << std::endl;
+    logSimulationEvents = false;
+
+    auto loadStart = std::chrono::steady_clock::now();
+
+    MeshLoaderObj loader;
+    std::vector<Mesh> staticMeshes;
+    for (const char* name : CRATE_MODELS)
+        staticMeshes.push_back(loader.loadObjGeometry(std::string(CRATE_MODEL_DIRECTORY) + name + ".obj"));
+
+    buildLevel(staticMeshes);
+
+    terrainGrid = buildTerrainGrid(TERRAIN_SIZE, TERRAIN_DIVISIONS, gameState.getHazardZones());
+    terrainPyramid = new TerrainHeightPyramid(terrainGrid);
+
+    std::chrono::duration<double, std::milli> loadTime = std::chrono::steady_clock::now() - loadStart;
+    std::cout << "Level loaded in " << loadTime.count() << " ms" << std::endl;
+
+    resetPlayer();
+
+    int gameOvers = 0;
+    int ticksRun = 0;
+    std::vector<double> frameTimes;
+    auto runStart = std::chrono::steady_clock::now();
+
+    if (replay) {
+        frameTimes.reserve(replay->getFrameCount());
+        for (int i = 0; i < replay->getFrameCount() && lives > 0; ++i) {
+            auto frameStart = std::chrono::steady_clock::now();
+            ticksRun += advanceFrame(replay->getFrame(i));
+            frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+        }
+    }
+    else {
+        for (int tick = 0; tick < ticks; ++tick) {
+            ticksRun += advanceFrame(scriptedInput(tick));
+            if (lives <= 0) {
+                gameOvers++;
+                lives = maxLives;
+                resetPlayer();
+            }
+        }
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    double simSeconds = ticksRun * static_cast<double>(SIM_TIMESTEP);
+    glm::vec3 pos = camera.getCameraPosition();
+
+    std::cout << "Ticks: " << ticksRun << " (" << simSeconds << " s simulated) in " << wallSeconds << " s" << std::endl;
+    std::cout << "Rate: " << ticksRun / wallSeconds << " ticks/s, " << simSeconds / wallSeconds << "x real time" << std::endl;
+    std::cout << "End state: pos=(" << pos.x << ", " << pos.y << ", " << pos.z << ")"
+        << " lives=" << lives << "/" << maxLives
+        << " gameOvers=" << gameOvers
+        << " objects=" << objects.size()
+        << " hazards=" << gameState.getHazardZones().size() << std::endl;
+    reportFrameTimes(frameTimes);
+    std::cout << "Checksum: " << std::hex << computeStateChecksum() << std::dec << std::endl;
+
+    delete terrainPyramid;
+    terrainPyramid = nullptr;
+    return 0;
+}
+
 // ---------- MAIN ----------
 
-int main()
+int main(int argc, char** argv)
 {
+    if (argc >= 3 && std::string(argv[1]) == "--bench")
+        return runBenchmark(argv[2]) ? 0 : 1;
+    if (argc >= 3 && std::string(argv[1]) == "--headless")
+        return runHeadless(std::atoi(argv[2]), nullptr);
+
+    // --record <file> saves this session's input on exit; --replay <file> plays one back
+    // in the window instead of taking input, or without it when followed by --headless
+    std::string recordPath;
+    InputLog replay;
+    bool replaying = false;
+    if (argc >= 3 && std::string(argv[1]) == "--record")
+        recordPath = argv[2];
+    if (argc >= 3 && std::string(argv[1]) == "--replay") {
+        if (!loadReplay(argv[2], replay))
+            return 1;
+        if (argc >= 4 && std::string(argv[3]) == "--headless")
+            return runHeadless(0, &replay);
+        replaying = true;
+    }
+
+    // --props <count> adds count scattered crates and reports frame times on exit
+    int propCount = 0;
+    if (argc >= 3 && std::string(argv[1]) == "--props")
+        propCount = std::max(0, std::atoi(argv[2]));
+
+    InputLog recording(SIM_TIMESTEP);
+    std::vector<double> frameTimes;
+
     std::cout << "=== Game start ===" << std::endl;
 
+    window = new Window("Alien Artifact Recovery", 1920, 1080);
+
     glClearColor(0.4f, 0.6f, 0.8f, 1.0f);
 
-    glfwSetInputMode(window.getWindow(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwSetCursorPosCallback(window.getWindow(), mouse_callback);
-    glfwSetScrollCallback(window.getWindow(), scroll_callback);
+    glfwSetInputMode(window->getWindow(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    glfwSetCursorPosCallback(window->getWindow(), mouse_callback);
+    glfwSetScrollCallback(window->getWindow(), scroll_callback);
 
     Shader shader("Shaders/vertex_shader.glsl", "Shaders/fragment_shader.glsl");
     Shader sunShader("Shaders/sun_vertex_shader.glsl", "Shaders/sun_fragment_shader.glsl");
+    Shader terrainShader(
+        USE_CLIPMAP_TERRAIN ? "Shaders/clipmap_vertex_shader.glsl" : "Shaders/terrain_vertex_shader.glsl",
+        "Shaders/fragment_shader.glsl");
 
     hudShader = new Shader("Shaders/hud_vertex_shader.glsl", "Shaders/hud_fragment_shader.glsl");
+    hudMvpUniform = hudShader->getUniform("MVP");
+    hudColorUniform = hudShader->getUniform("color");
+
+    GLint terrainTintUniform = terrainShader.getUniform("objectTint");
+    GLint objectTintUniform = shader.getUniform("objectTint");
+
+    frameUniforms = new UniformBuffer(FRAME_UNIFORMS_BINDING, sizeof(FrameUniformData));
+    sceneUniforms = new UniformBuffer(SCENE_UNIFORMS_BINDING, sizeof(SceneUniformData));
+    hazardTextures = new HazardTextures();
 
     {
         std::vector<Vertex> hudVertices(4);
@@ -384,222 +996,194 @@ int main()
     }
 
     GLuint sandTex = loadBMP("Resources/Textures/sand.bmp");
-    GLuint crate1x1Tex = loadBMP("Resources/Models/StaticObjects/crates/Crate_1x1_Mat_BaseColor.bmp");
-    GLuint crate1x1TallTex = loadBMP("Resources/Models/StaticObjects/crates/Crate_1x1_Tall_Mat_BaseColor.bmp");
-    GLuint crate1x2Tex = loadBMP("Resources/Models/StaticObjects/crates/Crate_1x2_Mat_BaseColor.bmp");
-    GLuint crate1x2TallTex = loadBMP("Resources/Models/StaticObjects/crates/Crate_1x2_Tall_Mat_BaseColor.bmp");
-    GLuint crate2x2TallTex = loadBMP("Resources/Models/StaticObjects/crates/Crate_2x2_Tall_Mat_BaseColor.bmp");
 
-    std::vector<Texture> crate1x1TexVec(1);
-    crate1x1TexVec[0].id = crate1x1Tex;
-    crate1x1TexVec[0].type = "texture_diffuse";
+    glEnable(GL_DEPTH_TEST);
 
-    std::vector<Texture> crate1x1TallTexVec(1);
-    crate1x1TallTexVec[0].id = crate1x1TallTex;
-    crate1x1TallTexVec[0].type = "texture_diffuse";
+    MeshLoaderObj loader;
+    Mesh sun = loader.loadObj("Resources/Models/sphere.obj");
 
-    std::vector<Texture> crate1x2TexVec(1);
-    crate1x2TexVec[0].id = crate1x2Tex;
-    crate1x2TexVec[0].type = "texture_diffuse";
+    std::vector<Mesh> staticMeshes;
+    for (const char* name : CRATE_MODELS) {
+        std::string path = std::string(CRATE_MODEL_DIRECTORY) + name;
 
-    std::vector<Texture> crate1x2TallTexVec(1);
-    crate1x2TallTexVec[0].id = crate1x2TallTex;
-    crate1x2TallTexVec[0].type = "texture_diffuse";
+        std::vector<Texture> textures(1);
+        textures[0].id = loadBMP((path + "_Mat_BaseColor.bmp").c_str());
+        textures[0].type = "texture_diffuse";
 
-    std::vector<Texture> crate2x2TallTexVec(1);
-    crate2x2TallTexVec[0].id = crate2x2TallTex;
-    crate2x2TallTexVec[0].type = "texture_diffuse";
+        staticMeshes.push_back(loader.loadObj(path + ".obj", textures));
+    }
 
-    glEnable(GL_DEPTH_TEST);
+    buildLevel(staticMeshes);
+    scatterProps(staticMeshes, propCount);
 
-    MeshLoaderObj loader;
-    Mesh sun = loader.loadObj("Resources/Models/sphere.obj");
+    auto terrainStart = std::chrono::steady_clock::now();
+    bool terrainFromCache = false;
 
-    std::vector<Mesh> staticMeshes;
+    if (USE_CLIPMAP_TERRAIN) {
+        terrainClipmap = new TerrainClipmap(sandTex, gameState.getHazardZones());
+        terrainClipmap->update(respawnPoint);
+    }
+    else {
+        terrainLOD = loadOrBuildTerrainLOD(TERRAIN_CACHE_PATH, TERRAIN_SIZE, TERRAIN_DIVISIONS, gameState.getHazardZones(),
+            sandTex, terrainGrid, terrainFromCache);
+        terrainPyramid = new TerrainHeightPyramid(terrainGrid);
+    }
 
-    staticMeshes.push_back(loader.loadObj("Resources/Models/StaticObjects/crates/Crate_1x1.obj", crate1x1TexVec));
-    staticMeshes.push_back(loader.loadObj("Resources/Models/StaticObjects/crates/Crate_1x1_Tall.obj", crate1x1TallTexVec));
-    staticMeshes.push_back(loader.loadObj("Resources/Models/StaticObjects/crates/Crate_1x2.obj", crate1x2TexVec));
-    staticMeshes.push_back(loader.loadObj("Resources/Models/StaticObjects/crates/Crate_1x2_Tall.obj", crate1x2TallTexVec));
-    staticMeshes.push_back(loader.loadObj("Resources/Models/StaticObjects/crates/Crate_2x2_Tall.obj", crate2x2TallTexVec));
-
-    objects.push_back({ &staticMeshes[0], glm::vec3(-80, 0, -80),   glm::vec3(7.5, 7.5, 7.5), 0 });
-    objects.push_back({ &staticMeshes[1], glm::vec3(-100, 0, -60),  glm::vec3(7.5, 7.5, 7.5), 30 });
-    objects.push_back({ &staticMeshes[2], glm::vec3(-120, 0, -70),  glm::vec3(7.5, 7.5, 7.5), 60 });
-    objects.push_back({ &staticMeshes[3], glm::vec3(150, 0, 120),   glm::vec3(9.0, 9.0, 9.0), 90 });
-    objects.push_back({ &staticMeshes[4], glm::vec3(170, 0, 140),   glm::vec3(10.0, 10.0, 10.0), 120 });
-    objects.push_back({ &staticMeshes[0], glm::vec3(-200, 0, 100),  glm::vec3(6.0, 6.0, 6.0), 150 });
-    objects.push_back({ &staticMeshes[2], glm::vec3(250, 0, -150),  glm::vec3(8.0, 8.0, 8.0), 180 });
-    objects.push_back({ &staticMeshes[1], glm::vec3(50, 0, 200),    glm::vec3(7.0, 7.0, 7.0), 210 });
-    objects.push_back({ &staticMeshes[3], glm::vec3(-300, 0, -50),  glm::vec3(8.5, 8.5, 8.5), 240 });
-    objects.push_back({ &staticMeshes[4], glm::vec3(300, 0, -200),  glm::vec3(11.0, 11.0, 11.0), 270 });
+    std::chrono::duration<double, std::milli> terrainTime = std::chrono::steady_clock::now() - terrainStart;
+    std::cout << (terrainFromCache ? "Terrain loaded from cache in " : "Terrain built in ") << terrainTime.count() << " ms ("
+        << (terrainLOD ? terrainLOD->getLevelCount() : terrainClipmap->getLevelCount())
+        << (terrainLOD ? " LOD levels)" : " clipmap levels)") << std::endl;
 
-    gameState.addHazardZone(glm::vec3(0, 0, 700), glm::vec3(20, 10, 20), 1, "Test Pit (ahead)");
-    gameState.addHazardZone(glm::vec3(50, 0, 50), glm::vec3(18, 10, 18), 1, "Radiation Pit Alpha");
-    gameState.addHazardZone(glm::vec3(-150, 0, -100), glm::vec3(22, 10, 22), 1, "Toxic Pit Beta");
-    gameState.addHazardZone(glm::vec3(200, 0, 150), glm::vec3(20, 10, 20), 1, "Crater Gamma");
-    gameState.addHazardZone(glm::vec3(-250, 0, 200), glm::vec3(25, 10, 25), 1, "Deep Pit Delta");
-    gameState.addHazardZone(glm::vec3(180, 0, -120), glm::vec3(15, 10, 15), 1, "Small Pit Epsilon");
-    gameState.addHazardZone(glm::vec3(-80, 0, 250), glm::vec3(18, 10, 18), 1, "Hazard Pit Zeta");
-    gameState.addHazardZone(glm::vec3(300, 0, 50), glm::vec3(23, 10, 23), 1, "Alien Crater Eta");
-    gameState.addHazardZone(glm::vec3(-200, 0, -200), glm::vec3(17, 10, 17), 1, "Dark Pit Theta");
-    gameState.addHazardZone(glm::vec3(100, 0, 300), glm::vec3(20, 10, 20), 1, "Danger Zone Iota");
+    if (terrainLOD)
+        std::cout << "Terrain GPU memory: " << terrainLOD->getGpuMemoryBytes() / 1024 << " KB" << std::endl;
 
-    Mesh terrain = createTerrainMesh(1000.0f, 500, sandTex, gameState.getHazardZones());
+    auto maskStart = std::chrono::steady_clock::now();
+    hazardMask = buildHazardMask(TERRAIN_SIZE, HAZARD_MASK_RESOLUTION, gameState.getHazardZones());
+    hazardTextures->setMask(hazardMask);
+    std::chrono::duration<double, std::milli> maskTime = std::chrono::steady_clock::now() - maskStart;
+    std::cout << "Hazard mask baked in " << maskTime.count() << " ms" << std::endl;
 
-    respawnPoint = glm::vec3(0.0f, STAND_HEIGHT, 780.0f);
-    camera.setCameraPosition(respawnPoint);
-    isGrounded = true;
-    isCrouching = false;
-    verticalVelocity = 0.0f;
+    resetPlayer();
+    lastFrame = static_cast<float>(glfwGetTime());
 
     int frameCounter = 0;
+    int replayFrame = 0;
 
-    while (!window.isPressed(GLFW_KEY_ESCAPE) &&
-        glfwWindowShouldClose(window.getWindow()) == 0 &&
+    while (!window->isPressed(GLFW_KEY_ESCAPE) &&
+        glfwWindowShouldClose(window->getWindow()) == 0 &&
         lives > 0)
     {
-        window.clear();
-
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+        window->clear();
 
         if (frameCounter % 120 == 0) {
             glm::vec3 camPos = camera.getCameraPosition();
             std::cout << "[Frame " << frameCounter
                 << "] cam=(" << camPos.x << ", " << camPos.y << ", " << camPos.z << ")"
                 << " lives=" << lives
-                << " isFalling=" << isFallingInPit << std::endl;
+                << " isFalling=" << isFallingInPit
+                << " objects=" << visibleObjects.size() << "/" << objects.size()
+                << " objectDraws=" << objectDrawCalls;
+
+            if (terrainLOD)
+                std::cout << " terrainNodes=" << terrainLOD->getSelectedNodeCount()
+                    << " terrainTris=" << terrainLOD->getSelectedTriangleCount();
+            else
+                std::cout << " terrainTris=" << terrainClipmap->getTriangleCount()
+                    << " clipmapSamples=" << terrainClipmap->getUpdatedSampleCount();
+
+            std::cout << std::endl;
         }
         frameCounter++;
 
-        if (!isFallingInPit) {
-            processKeyboardInput();
-
-            glm::vec3 pos = camera.getCameraPosition();
-
-            if (window.isPressed(GLFW_KEY_SPACE) && isGrounded && !isCrouching) {
-                verticalVelocity = JUMP_SPEED;
-                isGrounded = false;
-            }
+        float currentFrame = static_cast<float>(glfwGetTime());
+        float frameTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
 
-            if (!isGrounded) {
-                verticalVelocity += GRAVITY * deltaTime;
-                pos.y += verticalVelocity * deltaTime;
+        InputFrame frame;
+        if (replaying) {
+            if (replayFrame == replay.getFrameCount())
+                break;
+            frame = replay.getFrame(replayFrame++);
+        }
+        else {
+            for (int i = 0; i < INPUT_KEY_COUNT; ++i)
+                frame.setPressed(INPUT_KEYS[i], window->isPressed(INPUT_KEYS[i]));
+            frame.mouseDeltaX = pendingMouseX;
+            frame.mouseDeltaY = pendingMouseY;
+            frame.scroll = pendingScroll;
+            frame.frameTime = frameTime;
+        }
+        pendingMouseX = pendingMouseY = pendingScroll = 0.0f;
 
-                float currentGroundY = isCrouching ? CROUCH_HEIGHT : STAND_HEIGHT;
-                if (pos.y <= currentGroundY) {
-                    pos.y = currentGroundY;
-                    verticalVelocity = 0.0f;
-                    isGrounded = true;
-                }
-            }
-            else {
-                float currentGroundY = isCrouching ? CROUCH_HEIGHT : STAND_HEIGHT;
-                pos.y = currentGroundY;
-                verticalVelocity = 0.0f;
-            }
+        if (replaying || propCount > 0)
+            frameTimes.push_back(frameTime * 1000.0);
 
-            camera.setCameraPosition(pos);
+        if (!recordPath.empty())
+            recording.add(frame);
 
-            if (checkAnyPitFall(camera.getCameraPosition(), gameState.getHazardZones())) {
-                isFallingInPit = true;
-                fallStartTime = currentFrame;
-                verticalVelocity = -40.0f;
-                std::cout << "You fell into a pit! Lives left after this: " << (lives - 1) << std::endl;
-            }
+        // Fixed steps catch the simulation up with real time; the remainder of a step
+        // blends the last two simulated positions for display
+        advanceFrame(frame);
 
-        }
-        else {
-            glm::vec3 pos = camera.getCameraPosition();
-            verticalVelocity += GRAVITY * deltaTime;
-            pos.y += verticalVelocity * deltaTime;
-            camera.setCameraPosition(pos);
-
-            if (currentFrame - fallStartTime >= fallDuration) {
-                lives--;
-                isFallingInPit = false;
-                verticalVelocity = 0.0f;
-                isGrounded = true;
-                isCrouching = false;
-                camera.setCameraPosition(respawnPoint);
-                std::cout << "Respawned at start. Lives: " << lives << "/" << maxLives << std::endl;
-            }
-        }
+        float alpha = simAccumulator / SIM_TIMESTEP;
+        glm::vec3 eyePosition = glm::mix(previousSimPosition, camera.getCameraPosition(), alpha);
 
         glm::mat4 ProjectionMatrix = glm::perspective(
             glm::radians(fov),
-            window.getWidth() * 1.0f / window.getHeight(),
+            window->getWidth() * 1.0f / window->getHeight(),
             0.1f,
             10000.0f
         );
-        glm::mat4 ViewMatrix = camera.getViewMatrix();
+        glm::mat4 ViewMatrix = camera.getViewMatrix(eyePosition);
+        glm::mat4 ViewProjection = ProjectionMatrix * ViewMatrix;
+
+        updateFrameUniforms(ViewMatrix, ProjectionMatrix, eyePosition);
+        updateSceneUniforms();
+        uploadTerrainEdits();
 
         glBindTexture(GL_TEXTURE_2D, 0);
 
         sunShader.use();
-        GLuint MatrixID = glGetUniformLocation(sunShader.getId(), "MVP");
+        sun.draw(sunShader);
 
-        glm::mat4 ModelMatrix = glm::mat4(1.0f);
-        ModelMatrix = glm::translate(ModelMatrix, lightPos);
-        glm::mat4 MVP = ProjectionMatrix * ViewMatrix * ModelMatrix;
-        glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
+        terrainShader.use();
+        terrainShader.setVec3(terrainTintUniform, glm::vec3(1.0f));
 
-        sun.draw(sunShader);
+        if (terrainLOD) {
+            terrainLOD->select(eyePosition, ViewProjection);
+            terrainLOD->draw(terrainShader);
+        }
+        else {
+            terrainClipmap->update(eyePosition);
+            terrainClipmap->draw(terrainShader);
+        }
 
         shader.use();
-        GLuint MatrixID2 = glGetUniformLocation(shader.getId(), "MVP");
-        GLuint ModelMatrixID = glGetUniformLocation(shader.getId(), "model");
-        GLuint TintID = glGetUniformLocation(shader.getId(), "objectTint");
-
-        glUniform3f(glGetUniformLocation(shader.getId(), "lightColor"), lightColor.x, lightColor.y, lightColor.z);
-        glUniform3f(glGetUniformLocation(shader.getId(), "lightPos"), lightPos.x, lightPos.y, lightPos.z);
-        glUniform3f(glGetUniformLocation(shader.getId(), "viewPos"),
-            camera.getCameraPosition().x,
-            camera.getCameraPosition().y,
-            camera.getCameraPosition().z);
-
-        glm::mat4 ModelMatrixTerrain = glm::mat4(1.0f);
-        glm::mat4 MVPTerrain = ProjectionMatrix * ViewMatrix * ModelMatrixTerrain;
-
-        glUniformMatrix4fv(MatrixID2, 1, GL_FALSE, &MVPTerrain[0][0]);
-        glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrixTerrain[0][0]);
-        glUniform3f(TintID, 1.0f, 1.0f, 1.0f);
-
-        const auto& hazards = gameState.getHazardZones();
-        glUniform1i(glGetUniformLocation(shader.getId(), "numHazards"), static_cast<int>(hazards.size()));
-
-        for (int i = 0; i < static_cast<int>(hazards.size()) && i < 10; ++i) {
-            std::string posName = "hazardPositions[" + std::to_string(i) + "]";
-            std::string sizeName = "hazardSizes[" + std::to_string(i) + "]";
-
-            glUniform3f(glGetUniformLocation(shader.getId(), posName.c_str()),
-                hazards[i].position.x, hazards[i].position.y, hazards[i].position.z);
-            glUniform3f(glGetUniformLocation(shader.getId(), sizeName.c_str()),
-                hazards[i].size.x, hazards[i].size.y, hazards[i].size.z);
+        shader.setVec3(objectTintUniform, glm::vec3(1.0f));
+
+        visibleObjects.clear();
+        objectTree.query(Frustum(ViewProjection), visibleObjects);
+
+        for (auto& group : instanceModels)
+            group.second.clear();
+        for (int id : visibleObjects)
+            instanceModels[objects[id].mesh].push_back(objects[id].model);
+
+        objectDrawCalls = 0;
+        for (auto& group : instanceModels) {
+            if (group.second.empty())
+                continue;
+            group.first->drawInstanced(shader, group.second.data(), static_cast<int>(group.second.size()));
+            objectDrawCalls++;
         }
 
-        terrain.draw(shader);
-
-        for (const auto& obj : objects) {
-            ModelMatrix = glm::mat4(1.0f);
-            ModelMatrix = glm::translate(ModelMatrix, obj.position);
-            ModelMatrix = glm::rotate(ModelMatrix, glm::radians(obj.rotationY), glm::vec3(0, 1, 0));
-            ModelMatrix = glm::scale(ModelMatrix, obj.scale);
-
-            MVP = ProjectionMatrix * ViewMatrix * ModelMatrix;
-
-            glUniformMatrix4fv(MatrixID2, 1, GL_FALSE, &MVP[0][0]);
-            glUniformMatrix4fv(ModelMatrixID, 1, GL_FALSE, &ModelMatrix[0][0]);
-            glUniform3f(TintID, 1.0f, 1.0f, 1.0f);
+        drawHeartsHUD(lives);
 
-            obj.mesh->draw(shader);
-        }
+        window->update();
+    }
 
-        drawHeartsHUD(lives);
+    delete terrainPyramid;
+    delete terrainLOD;
+    delete terrainClipmap;
+    delete frameUniforms;
+    delete sceneUniforms;
+    delete hazardTextures;
+    delete window;
+
+    if (!recordPath.empty() && recording.save(recordPath))
+        std::cout << "Recorded " << recording.getFrameCount() << " frames to " << recordPath << std::endl;
+
+    if (replaying) {
+        std::cout << "Replayed " << replayFrame << " of " << replay.getFrameCount() << " frames" << std::endl;
+        reportFrameTimes(frameTimes);
+        std::cout << "Checksum: " << std::hex << computeStateChecksum() << std::dec << std::endl;
+        return 0;
+    }
 
-        window.update();
+    if (propCount > 0) {
+        std::cout << "Last frame drew " << visibleObjects.size() << " of " << objects.size() << " objects in "
+            << objectDrawCalls << " draw calls" << std::endl;
+        reportFrameTimes(frameTimes);
     }
 
     std::cout << "\nGame over. Final lives: " << lives << std::endl;
@@ -616,10 +1200,10 @@ void processKeyboardInput()
     if (isFallingInPit)
         return;
 
-    float baseSpeed = 30.0f * deltaTime;
+    float baseSpeed = 30.0f * SIM_TIMESTEP;
     float cameraSpeed = isCrouching ? baseSpeed * 0.5f : baseSpeed;
 
-    bool crouchKey = window.isPressed(GLFW_KEY_LEFT_CONTROL);
+    bool crouchKey = input.isPressed(GLFW_KEY_LEFT_CONTROL);
     if (crouchKey) {
         if (!isCrouching && isGrounded) {
             isCrouching = true;
@@ -637,57 +1221,49 @@ void processKeyboardInput()
         }
     }
 
-    bool mKey = window.isPressed(GLFW_KEY_M);
+    bool mKey = input.isPressed(GLFW_KEY_M);
     if (mKey && !mKeyWasPressed) {
         currentSensitivityIndex++;
         if (currentSensitivityIndex >= static_cast<int>(sizeof(sensitivities) / sizeof(float)))
             currentSensitivityIndex = 0;
 
-        std::cout << "Mouse sensitivity set to "
+        if (logSimulationEvents)
+            std::cout << "Mouse sensitivity set to "
             << sensitivities[currentSensitivityIndex] << std::endl;
     }
     mKeyWasPressed = mKey;
 
-    if (window.isPressed(GLFW_KEY_W)) {
-        glm::vec3 oldPos = camera.getCameraPosition();
-        camera.keyboardMoveFront(cameraSpeed * 4.0f);
-        if (checkAllCollisions(camera.getCameraPosition(), objects))
-            camera.setCameraPosition(oldPos);
-    }
+    // Keys add up to one displacement, walked on the ground plane; jumps move Y
+    glm::vec3 front = camera.getCameraViewDirection();
+    glm::vec3 right = camera.getCameraRight();
+    front.y = 0.0f;
+    right.y = 0.0f;
 
-    if (window.isPressed(GLFW_KEY_S)) {
-        glm::vec3 oldPos = camera.getCameraPosition();
-        camera.keyboardMoveBack(cameraSpeed * 4.0f);
-        if (checkAllCollisions(camera.getCameraPosition(), objects))
-            camera.setCameraPosition(oldPos);
-    }
+    glm::vec3 move(0.0f);
+    if (input.isPressed(GLFW_KEY_W))
+        move += front * (cameraSpeed * 4.0f);
+    if (input.isPressed(GLFW_KEY_S))
+        move -= front * (cameraSpeed * 4.0f);
+    if (input.isPressed(GLFW_KEY_A))
+        move -= right * cameraSpeed;
+    if (input.isPressed(GLFW_KEY_D))
+        move += right * cameraSpeed;
 
-    if (window.isPressed(GLFW_KEY_A)) {
-        glm::vec3 oldPos = camera.getCameraPosition();
-        camera.keyboardMoveLeft(cameraSpeed);  // sign already set in camera.cpp
-        if (checkAllCollisions(camera.getCameraPosition(), objects))
-            camera.setCameraPosition(oldPos);
-    }
-
-    if (window.isPressed(GLFW_KEY_D)) {
-        glm::vec3 oldPos = camera.getCameraPosition();
-        camera.keyboardMoveRight(cameraSpeed);
-        if (checkAllCollisions(camera.getCameraPosition(), objects))
-            camera.setCameraPosition(oldPos);
-    }
+    if (move != glm::vec3(0.0f))
+        movePlayer(move);
 
-    float rotSpeed = glm::radians(60.0f) * deltaTime;
+    float rotSpeed = glm::radians(60.0f) * SIM_TIMESTEP;
 
-    if (window.isPressed(GLFW_KEY_LEFT)) {
+    if (input.isPressed(GLFW_KEY_LEFT)) {
         camera.rotateOy(rotSpeed);      // look left
     }
-    if (window.isPressed(GLFW_KEY_RIGHT)) {
+    if (input.isPressed(GLFW_KEY_RIGHT)) {
         camera.rotateOy(-rotSpeed);     // look right
     }
-    if (window.isPressed(GLFW_KEY_UP)) {
+    if (input.isPressed(GLFW_KEY_UP)) {
         camera.rotateOx(rotSpeed);
     }
-    if (window.isPressed(GLFW_KEY_DOWN)) {
+    if (input.isPressed(GLFW_KEY_DOWN)) {
         camera.rotateOx(-rotSpeed);
     }
 }
\ No newline at end of file